@@ -0,0 +1,225 @@
+#include <pebble.h>
+#include "location_profiles.h"
+#include "prayer_data.h"
+
+// Persist chunks per profile (PERSIST_DATA_MAX_LENGTH bytes each)
+#define PROFILE_STORAGE_KEYS 4
+
+// Profile slots and the active one
+static LocationProfile s_profiles[PROFILE_MAX_COUNT];
+static uint8_t s_active_slot = 0;
+
+// Storage key of the first chunk for a slot
+static uint32_t profile_storage_key(uint8_t slot) {
+    return STORAGE_KEY_PROFILE_BASE + (slot * PROFILE_STORAGE_KEYS);
+}
+
+// Write a profile across consecutive persist keys
+static void profile_save(uint8_t slot) {
+    const uint8_t *data = (const uint8_t *)&s_profiles[slot];
+    uint32_t key = profile_storage_key(slot);
+    size_t remaining = sizeof(LocationProfile);
+
+    while (remaining > 0) {
+        size_t chunk = remaining < PERSIST_DATA_MAX_LENGTH ? remaining : PERSIST_DATA_MAX_LENGTH;
+        persist_write_data(key++, data, chunk);
+        data += chunk;
+        remaining -= chunk;
+    }
+}
+
+// Read a profile back from consecutive persist keys
+static bool profile_load(uint8_t slot) {
+    uint8_t *data = (uint8_t *)&s_profiles[slot];
+    uint32_t key = profile_storage_key(slot);
+    size_t remaining = sizeof(LocationProfile);
+
+    while (remaining > 0) {
+        size_t chunk = remaining < PERSIST_DATA_MAX_LENGTH ? remaining : PERSIST_DATA_MAX_LENGTH;
+        if (persist_read_data(key++, data, chunk) != (int)chunk) {
+            memset(&s_profiles[slot], 0, sizeof(LocationProfile));
+            return false;
+        }
+        data += chunk;
+        remaining -= chunk;
+    }
+    return true;
+}
+
+// Index of today within a profile schedule, or -1 if not covered
+static int profile_day_index(const LocationProfile *profile, time_t today) {
+    if (profile->num_days == 0) return -1;
+
+    // Round to the nearest day so 23h/25h DST days don't shift the index
+    int32_t diff = (int32_t)(today - (time_t)profile->start_day);
+    if (diff < -43200) return -1;
+    int day = (diff + 43200) / 86400;
+
+    return (day < profile->num_days) ? day : -1;
+}
+
+// Absolute time of a prayer, minutes after the given local midnight
+static time_t prayer_epoch(time_t midnight, int16_t minutes) {
+    struct tm tm_prayer = *localtime(&midnight);
+    tm_prayer.tm_hour = minutes / 60;
+    tm_prayer.tm_min = minutes % 60;
+    tm_prayer.tm_sec = 0;
+    tm_prayer.tm_isdst = -1;
+    return mktime(&tm_prayer);
+}
+
+void location_profiles_init(void) {
+    memset(s_profiles, 0, sizeof(s_profiles));
+
+    // Nothing stored yet (fresh install)
+    if (!persist_exists(STORAGE_KEY_VERSION)) {
+        return;
+    }
+
+    // Drop profiles written with an older layout
+    if (persist_read_int(STORAGE_KEY_VERSION) != STORAGE_VERSION) {
+        for (uint32_t key = profile_storage_key(0); key < profile_storage_key(PROFILE_MAX_COUNT); key++) {
+            persist_delete(key);
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i < PROFILE_MAX_COUNT; i++) {
+        if (persist_exists(profile_storage_key(i))) {
+            profile_load(i);
+        }
+    }
+
+    if (persist_exists(STORAGE_KEY_ACTIVE_PROFILE)) {
+        int32_t active = persist_read_int(STORAGE_KEY_ACTIVE_PROFILE);
+        if (active >= 0 && active < PROFILE_MAX_COUNT) {
+            s_active_slot = (uint8_t)active;
+        }
+    }
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Loaded location profiles (active: %d)", s_active_slot);
+}
+
+void location_profiles_store(uint8_t slot, const char *name, uint32_t start_day,
+                             int32_t qibla_angle, const uint8_t *schedule, uint16_t length) {
+    if (slot >= PROFILE_MAX_COUNT) return;
+
+    LocationProfile *profile = &s_profiles[slot];
+    memset(profile, 0, sizeof(LocationProfile));
+    profile->qibla_angle = -1;
+
+    if (schedule) {
+        uint16_t day_size = sizeof(profile->schedule[0]);
+        uint16_t days = length / day_size;
+        if (days > PROFILE_SCHEDULE_DAYS) days = PROFILE_SCHEDULE_DAYS;
+
+        if (name) {
+            strncpy(profile->name, name, sizeof(profile->name) - 1);
+        }
+        profile->start_day = start_day;
+        profile->qibla_angle = qibla_angle;
+        profile->num_days = (uint8_t)days;
+        memcpy(profile->schedule, schedule, days * day_size);
+    }
+
+    persist_write_int(STORAGE_KEY_VERSION, STORAGE_VERSION);
+    profile_save(slot);
+
+    APP_LOG(APP_LOG_LEVEL_DEBUG, "Stored profile %d (%d days)", slot, profile->num_days);
+}
+
+int location_profiles_get_day_index(const LocationProfile *profile) {
+    return profile_day_index(profile, time_start_of_today());
+}
+
+const LocationProfile* location_profiles_get(uint8_t slot) {
+    return (slot < PROFILE_MAX_COUNT) ? &s_profiles[slot] : NULL;
+}
+
+uint8_t location_profiles_get_active(void) {
+    return s_active_slot;
+}
+
+bool location_profiles_set_active(uint8_t slot) {
+    // Only slots whose schedule covers today can be shown
+    if (slot >= PROFILE_MAX_COUNT ||
+        profile_day_index(&s_profiles[slot], time_start_of_today()) < 0) {
+        return false;
+    }
+
+    if (slot != s_active_slot) {
+        s_active_slot = slot;
+        persist_write_int(STORAGE_KEY_ACTIVE_PROFILE, slot);
+    }
+    return true;
+}
+
+bool location_profiles_cycle(void) {
+    for (uint8_t i = 1; i < PROFILE_MAX_COUNT; i++) {
+        uint8_t slot = (s_active_slot + i) % PROFILE_MAX_COUNT;
+        if (location_profiles_set_active(slot)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint8_t location_profiles_get_coverage_mask(void) {
+    time_t today = time_start_of_today();
+    uint8_t mask = 0;
+
+    for (uint8_t i = 0; i < PROFILE_MAX_COUNT; i++) {
+        int day = profile_day_index(&s_profiles[i], today);
+        if (day >= 0 && s_profiles[i].num_days - day >= PROFILE_MIN_REMAINING_DAYS) {
+            mask |= (1 << i);
+        }
+    }
+    return mask;
+}
+
+bool location_profiles_apply(void) {
+    const LocationProfile *profile = &s_profiles[s_active_slot];
+    time_t now = time(NULL);
+    time_t today = time_start_of_today();
+
+    int day = profile_day_index(profile, today);
+    if (day < 0) return false;
+
+    // Find the next prayer today, or tomorrow's Fajr once Isha has passed
+    PrayerIndex next = PRAYER_COUNT;
+    int16_t next_minutes = -1;
+    time_t next_epoch = 0;
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        next_epoch = prayer_epoch(today, profile->schedule[day][i]);
+        if (next_epoch > now) {
+            next = (PrayerIndex)i;
+            next_minutes = profile->schedule[day][i];
+            break;
+        }
+    }
+
+    if (next == PRAYER_COUNT) {
+        if (day + 1 >= profile->num_days) return false;
+        next = PRAYER_FAJR;
+        next_minutes = profile->schedule[day + 1][PRAYER_FAJR];
+        next_epoch = prayer_epoch(today + 86400, next_minutes);
+    }
+
+    memcpy(g_prayer_data.times, profile->schedule[day], sizeof(g_prayer_data.times));
+    strncpy(g_prayer_data.next_prayer_name, prayer_data_get_name(next),
+            sizeof(g_prayer_data.next_prayer_name) - 1);
+    format_time_from_minutes(next_minutes, g_prayer_data.next_prayer_time,
+                             sizeof(g_prayer_data.next_prayer_time));
+    strncpy(g_prayer_data.location_name, profile->name, sizeof(g_prayer_data.location_name) - 1);
+
+    g_prayer_data.next_prayer_index = next;
+    g_prayer_data.current_prayer_index = prayer_data_get_current(next);
+    g_prayer_data.next_prayer_epoch = (uint32_t)next_epoch;
+    g_prayer_data.countdown_seconds = prayer_data_seconds_remaining();
+    g_prayer_data.data_valid = true;
+    g_prayer_data.error_code = 0;
+    g_prayer_data.last_update_time = (uint32_t)now;
+
+    // Not persisted here - the profile schedule is already in storage
+    return true;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <pebble.h>
+#include "prayer_data.h"
+
+// Number of profile slots (slot 0 is the phone's current location)
+#define PROFILE_MAX_COUNT 3
+
+// Days of precomputed prayer times kept per profile
+#define PROFILE_SCHEDULE_DAYS 30
+
+// Days a schedule must still cover before the phone is asked to extend it
+#define PROFILE_MIN_REMAINING_DAYS 7
+
+// A named location with its precomputed schedule
+typedef struct {
+    char name[32];                                         // Location display name
+    uint32_t start_day;                                    // Local midnight of schedule day 0
+    uint8_t num_days;                                      // Days in schedule (0 = empty slot)
+    int32_t qibla_angle;                                   // Qibla bearing from true north (trig angle, -1 = unknown)
+    int16_t schedule[PROFILE_SCHEDULE_DAYS][PRAYER_COUNT]; // Minutes since midnight per day
+} LocationProfile;
+
+// Load profiles and the active slot from persistent storage
+void location_profiles_init(void);
+
+// Store a profile received from the phone (a NULL schedule clears the slot)
+void location_profiles_store(uint8_t slot, const char *name, uint32_t start_day,
+                             int32_t qibla_angle, const uint8_t *schedule, uint16_t length);
+
+// Get a profile slot, or NULL if out of range
+const LocationProfile* location_profiles_get(uint8_t slot);
+
+// Index of today within a profile's schedule, or -1 if not covered
+int location_profiles_get_day_index(const LocationProfile *profile);
+
+// Get the active profile slot
+uint8_t location_profiles_get_active(void);
+
+// Make a slot active; returns false if the slot's schedule doesn't cover today
+bool location_profiles_set_active(uint8_t slot);
+
+// Switch to the next slot whose schedule covers today; returns false if there is none
+bool location_profiles_cycle(void);
+
+// Bitmask of slots whose schedule still covers PROFILE_MIN_REMAINING_DAYS
+uint8_t location_profiles_get_coverage_mask(void);
+
+// Fill g_prayer_data from the active profile's schedule for the current time
+// Returns false if the schedule doesn't cover today
+bool location_profiles_apply(void);
@@ -2,7 +2,10 @@
 #include "prayer_data.h"
 #include "prayer_display.h"
 #include "prayer_list.h"
+#include "prayer_month.h"
+#include "prayer_qibla.h"
 #include "message_handler.h"
+#include "location_profiles.h"
 
 // Global prayer data instance
 PrayerData g_prayer_data = {
@@ -10,6 +13,7 @@ PrayerData g_prayer_data = {
     .next_prayer_name = "",
     .next_prayer_time = "",
     .countdown_seconds = 0,
+    .next_prayer_epoch = 0,
     .location_name = "",
     .data_valid = false,
     .error_code = 0,
@@ -19,6 +23,29 @@ PrayerData g_prayer_data = {
     .last_update_time = 0
 };
 
+// Prayer names, indexed by PrayerIndex
+static const char* PRAYER_NAMES[PRAYER_COUNT] = {
+    "Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha"
+};
+
+const char* prayer_data_get_name(PrayerIndex index) {
+    return (index < PRAYER_COUNT) ? PRAYER_NAMES[index] : "";
+}
+
+// Get the current prayer (the one before next prayer)
+// Maps to the 5 main prayers only (Fajr, Dhuhr, Asr, Maghrib, Isha)
+PrayerIndex prayer_data_get_current(PrayerIndex next) {
+    switch (next) {
+        case PRAYER_FAJR:    return PRAYER_ISHA;    // After Isha, waiting for Fajr
+        case PRAYER_SUNRISE: return PRAYER_FAJR;    // After Fajr, before Sunrise
+        case PRAYER_DHUHR:   return PRAYER_FAJR;    // After Sunrise, Fajr is still current
+        case PRAYER_ASR:     return PRAYER_DHUHR;   // After Dhuhr, waiting for Asr
+        case PRAYER_MAGHRIB: return PRAYER_ASR;     // After Asr, waiting for Maghrib
+        case PRAYER_ISHA:    return PRAYER_MAGHRIB; // After Maghrib, waiting for Isha
+        default:             return PRAYER_ISHA;
+    }
+}
+
 // Save prayer data to persistent storage
 void prayer_data_save(void) {
     persist_write_int(STORAGE_KEY_VERSION, STORAGE_VERSION);
@@ -26,6 +53,12 @@ void prayer_data_save(void) {
     APP_LOG(APP_LOG_LEVEL_DEBUG, "Prayer data saved to storage");
 }
 
+// Seconds until the next prayer (never negative)
+int32_t prayer_data_seconds_remaining(void) {
+    int32_t remaining = (int32_t)(g_prayer_data.next_prayer_epoch - (uint32_t)time(NULL));
+    return remaining > 0 ? remaining : 0;
+}
+
 // Load prayer data from persistent storage
 // Returns true if valid cached data was loaded
 bool prayer_data_load(void) {
@@ -59,12 +92,11 @@ bool prayer_data_load(void) {
         return false;
     }
 
-    // Recalculate countdown based on stored times and current time
-    // This adjusts the countdown to account for time passed since cache
-    if (g_prayer_data.data_valid && g_prayer_data.countdown_seconds > 0) {
-        int32_t elapsed = (int32_t)cache_age;
-        g_prayer_data.countdown_seconds -= elapsed;
-        if (g_prayer_data.countdown_seconds < 0) {
+    // Countdown is derived from the stored absolute prayer time, so no
+    // adjustment is needed - only check that the next prayer hasn't passed
+    if (g_prayer_data.data_valid) {
+        g_prayer_data.countdown_seconds = prayer_data_seconds_remaining();
+        if (g_prayer_data.countdown_seconds <= 0) {
             g_prayer_data.countdown_seconds = 0;
             // Data is stale, need refresh
             g_prayer_data.data_valid = false;
@@ -80,6 +112,7 @@ bool prayer_data_load(void) {
 static void on_prayer_data_updated(void) {
     prayer_display_update();
     prayer_list_update();
+    prayer_month_update();
 }
 
 // App initialization
@@ -88,12 +121,17 @@ static void init(void) {
     message_handler_init();
     message_handler_set_update_callback(on_prayer_data_updated);
 
-    // Initialize both windows
+    // Initialize all windows
     prayer_display_init();
     prayer_list_init();
+    prayer_month_init();
+    prayer_qibla_init();
 
-    // Try to load cached data for instant display
-    bool has_cache = prayer_data_load();
+    // Load saved location profiles
+    location_profiles_init();
+
+    // Try the active profile's schedule, then the cached data, for instant display
+    bool has_cache = location_profiles_apply() || prayer_data_load();
 
     // Push main window
     window_stack_push(prayer_display_get_window(), true);
@@ -111,11 +149,11 @@ static void init(void) {
 
 // App cleanup
 static void deinit(void) {
-    // Save current data before exit
-    if (g_prayer_data.data_valid) {
-        prayer_data_save();
-    }
+    // Prayer data is persisted when it arrives from the phone and isn't
+    // mutated by the tick handler, so there is nothing to flush here
 
+    prayer_qibla_deinit();
+    prayer_month_deinit();
     prayer_list_deinit();
     prayer_display_deinit();
     message_handler_deinit();
@@ -1,6 +1,7 @@
 #include <pebble.h>
 #include "message_handler.h"
 #include "prayer_data.h"
+#include "location_profiles.h"
 
 // Message keys (must match package.json messageKeys order)
 enum {
@@ -17,7 +18,14 @@ enum {
     KEY_LOCATION_NAME,
     KEY_ERROR_CODE,
     KEY_ERROR_MESSAGE,
-    KEY_NEXT_PRAYER_INDEX
+    KEY_NEXT_PRAYER_INDEX,
+    KEY_PROFILE_INDEX,
+    KEY_PROFILE_NAME,
+    KEY_PROFILE_START,
+    KEY_PROFILE_SCHEDULE,
+    KEY_ACTIVE_PROFILE,
+    KEY_PROFILE_MASK,
+    KEY_QIBLA_ANGLE
 };
 
 // Callback for data updates
@@ -34,22 +42,59 @@ static PrayerIndex get_prayer_index_from_name(const char* name) {
     return PRAYER_FAJR; // Default
 }
 
-// Get the current prayer (the one before next prayer)
-// Maps to the 5 main prayers only (Fajr, Dhuhr, Asr, Maghrib, Isha)
-static PrayerIndex get_current_prayer(PrayerIndex next) {
-    switch (next) {
-        case PRAYER_FAJR:    return PRAYER_ISHA;    // After Isha, waiting for Fajr
-        case PRAYER_SUNRISE: return PRAYER_FAJR;    // After Fajr, before Sunrise
-        case PRAYER_DHUHR:   return PRAYER_FAJR;    // After Sunrise, Fajr is still current
-        case PRAYER_ASR:     return PRAYER_DHUHR;   // After Dhuhr, waiting for Asr
-        case PRAYER_MAGHRIB: return PRAYER_ASR;     // After Asr, waiting for Maghrib
-        case PRAYER_ISHA:    return PRAYER_MAGHRIB; // After Maghrib, waiting for Isha
-        default:             return PRAYER_ISHA;
+// Handle a location profile schedule and/or active profile change
+// Returns true if the message was a profile message
+static bool handle_profile_message(DictionaryIterator *iterator) {
+    Tuple *index_tuple = dict_find(iterator, KEY_PROFILE_INDEX);
+    Tuple *active_tuple = dict_find(iterator, KEY_ACTIVE_PROFILE);
+    if (!index_tuple && !active_tuple) {
+        return false;
     }
+
+    if (index_tuple) {
+        // A profile without a schedule clears the slot
+        Tuple *name = dict_find(iterator, KEY_PROFILE_NAME);
+        Tuple *start = dict_find(iterator, KEY_PROFILE_START);
+        Tuple *schedule = dict_find(iterator, KEY_PROFILE_SCHEDULE);
+        Tuple *qibla = dict_find(iterator, KEY_QIBLA_ANGLE);
+        location_profiles_store((uint8_t)index_tuple->value->int32,
+                                name ? name->value->cstring : NULL,
+                                start ? (uint32_t)start->value->int32 : 0,
+                                qibla ? qibla->value->int32 : -1,
+                                schedule ? schedule->value->data : NULL,
+                                schedule ? schedule->length : 0);
+    }
+
+    if (active_tuple) {
+        location_profiles_set_active((uint8_t)active_tuple->value->int32);
+    }
+
+    // Fall back to the current location if the active slot was cleared
+    if (!location_profiles_apply() && location_profiles_get_active() != 0) {
+        location_profiles_set_active(0);
+        location_profiles_apply();
+    }
+
+    if (s_update_callback) {
+        s_update_callback();
+    }
+    return true;
 }
 
 // Inbox received handler
 static void inbox_received_handler(DictionaryIterator *iterator, void *context) {
+    if (handle_profile_message(iterator)) {
+        return;
+    }
+
+    // Current-location data doesn't apply while a saved profile is active
+    if (location_profiles_get_active() != 0 && location_profiles_apply()) {
+        if (s_update_callback) {
+            s_update_callback();
+        }
+        return;
+    }
+
     // Check for error first
     Tuple *error_tuple = dict_find(iterator, KEY_ERROR_CODE);
     if (error_tuple && error_tuple->value->int32 != 0) {
@@ -94,7 +139,7 @@ static void inbox_received_handler(DictionaryIterator *iterator, void *context)
                 sizeof(g_prayer_data.next_prayer_name) - 1);
         // Derive indices from name
         g_prayer_data.next_prayer_index = get_prayer_index_from_name(next_name->value->cstring);
-        g_prayer_data.current_prayer_index = get_current_prayer(g_prayer_data.next_prayer_index);
+        g_prayer_data.current_prayer_index = prayer_data_get_current(g_prayer_data.next_prayer_index);
     }
 
     Tuple *next_time = dict_find(iterator, KEY_NEXT_PRAYER_TIME);
@@ -103,9 +148,13 @@ static void inbox_received_handler(DictionaryIterator *iterator, void *context)
                 sizeof(g_prayer_data.next_prayer_time) - 1);
     }
 
-    // Parse countdown in seconds
+    // Parse countdown in seconds and anchor it to an absolute time so the
+    // display stays correct across missed ticks and clock changes
     Tuple *countdown = dict_find(iterator, KEY_COUNTDOWN_SECONDS);
-    if (countdown) g_prayer_data.countdown_seconds = countdown->value->int32;
+    if (countdown) {
+        g_prayer_data.countdown_seconds = countdown->value->int32;
+        g_prayer_data.next_prayer_epoch = (uint32_t)time(NULL) + countdown->value->int32;
+    }
 
     // Parse location
     Tuple *location = dict_find(iterator, KEY_LOCATION_NAME);
@@ -169,8 +218,10 @@ void message_handler_request_data(void) {
         return;
     }
 
-    // Send request flag
+    // Send request flag, plus which profile schedules still need the phone
     dict_write_int8(iter, KEY_REQUEST_DATA, 1);
+    dict_write_int8(iter, KEY_ACTIVE_PROFILE, location_profiles_get_active());
+    dict_write_int8(iter, KEY_PROFILE_MASK, location_profiles_get_coverage_mask());
 
     result = app_message_outbox_send();
     if (result != APP_MSG_OK) {
@@ -181,3 +232,20 @@ void message_handler_request_data(void) {
 void message_handler_set_update_callback(PrayerDataUpdateCallback callback) {
     s_update_callback = callback;
 }
+
+void message_handler_send_active_profile(void) {
+    DictionaryIterator *iter;
+    AppMessageResult result = app_message_outbox_begin(&iter);
+
+    if (result != APP_MSG_OK) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to begin outbox: %d", result);
+        return;
+    }
+
+    dict_write_int8(iter, KEY_ACTIVE_PROFILE, location_profiles_get_active());
+
+    result = app_message_outbox_send();
+    if (result != APP_MSG_OK) {
+        APP_LOG(APP_LOG_LEVEL_ERROR, "Failed to send message: %d", result);
+    }
+}
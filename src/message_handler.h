@@ -11,6 +11,9 @@ void message_handler_deinit(void);
 // Request prayer data from phone
 void message_handler_request_data(void);
 
+// Tell the phone which location profile is active
+void message_handler_send_active_profile(void);
+
 // Callback type for when prayer data is updated
 typedef void (*PrayerDataUpdateCallback)(void);
 
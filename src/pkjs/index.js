@@ -7,6 +7,8 @@ var prayerTimes = require('./prayer_times');
 var location = require('./location');
 var settings = require('./settings');
 var timeline = require('./timeline');
+var profiles = require('./profiles');
+var configPage = require('./config_page');
 
 // Message keys (must match package.json and C code)
 var KEYS = {
@@ -23,7 +25,14 @@ var KEYS = {
     LOCATION_NAME: 10,
     ERROR_CODE: 11,
     ERROR_MESSAGE: 12,
-    NEXT_PRAYER_INDEX: 13
+    NEXT_PRAYER_INDEX: 13,
+    PROFILE_INDEX: 14,
+    PROFILE_NAME: 15,
+    PROFILE_START: 16,
+    PROFILE_SCHEDULE: 17,
+    ACTIVE_PROFILE: 18,
+    PROFILE_MASK: 19,
+    QIBLA_ANGLE: 20
 };
 
 // Error codes
@@ -35,6 +44,37 @@ var ERROR = {
     APPMESSAGE: 4
 };
 
+// Pipeline stages, in dependency order (each stage implies the ones after it)
+var STAGE = {
+    NONE: 0,
+    TIMELINE: 1,
+    TIMES: 2,
+    LOCATION: 3
+};
+
+// Which pipeline stage each setting feeds into
+var SETTING_STAGES = {
+    calculationMethod: STAGE.TIMES,
+    asrMethod: STAGE.TIMES,
+    manualLocation: STAGE.LOCATION,
+    manualLatitude: STAGE.LOCATION,
+    manualLongitude: STAGE.LOCATION,
+    timelineEnabled: STAGE.TIMELINE,
+    reminderMinutes: STAGE.TIMELINE,
+    vibrationEnabled: STAGE.NONE,
+    profiles: STAGE.NONE    // Synced separately, see syncProfiles()
+};
+
+// Last computed result, reused when a settings change skips earlier stages
+var lastResult = null;
+
+// Profile schedules the watch reported as covered (null until it asks)
+var watchCoverageMask = null;
+
+// Profile sync state (messages are sent one at a time)
+var profileSyncActive = false;
+var profileSyncPending = false;
+
 // Retry state
 var retryCount = 0;
 var MAX_RETRIES = 3;
@@ -92,6 +132,93 @@ function sendError(code, message) {
     );
 }
 
+/**
+ * Tell the watch to switch location profile
+ * @param {number} slot - Profile slot
+ */
+function sendActiveProfile(slot) {
+    var dict = {};
+    dict[KEYS.ACTIVE_PROFILE] = slot;
+
+    Pebble.sendAppMessage(dict,
+        function() {
+            console.log('Active profile sent: ' + slot);
+            profiles.setActiveSlot(slot);
+        },
+        function() {
+            console.log('Failed to send active profile');
+        }
+    );
+}
+
+/**
+ * Send precomputed schedules for any profile slots the watch is missing
+ * Runs a single send at a time; a request made mid-sync runs once it ends.
+ */
+function syncProfiles() {
+    if (watchCoverageMask === null) {
+        // Watch hasn't reported what it holds yet
+        return;
+    }
+    if (profileSyncActive) {
+        profileSyncPending = true;
+        return;
+    }
+
+    var currentSettings = settings.loadSettings();
+    var current = lastResult ? {
+        name: profiles.truncateUtf8(lastResult.locationName, profiles.NAME_MAX_BYTES),
+        latitude: lastResult.latitude,
+        longitude: lastResult.longitude,
+        calculationMethod: currentSettings.calculationMethod,
+        asrMethod: currentSettings.asrMethod
+    } : null;
+
+    var pending = profiles.getPendingSlots(current, watchCoverageMask);
+    if (pending.length === 0) {
+        return;
+    }
+
+    profileSyncActive = true;
+
+    function sendNext(i) {
+        if (i >= pending.length) {
+            profileSyncActive = false;
+            if (profileSyncPending) {
+                profileSyncPending = false;
+                syncProfiles();
+            }
+            return;
+        }
+
+        var entry = pending[i];
+        var payload = profiles.buildPayload(entry.profile);
+        var dict = {};
+        dict[KEYS.PROFILE_INDEX] = entry.slot;
+        if (entry.profile) {
+            dict[KEYS.PROFILE_NAME] = payload.name;
+            dict[KEYS.PROFILE_START] = payload.start;
+            dict[KEYS.QIBLA_ANGLE] = payload.qibla;
+            dict[KEYS.PROFILE_SCHEDULE] = payload.schedule;
+        }
+
+        Pebble.sendAppMessage(dict,
+            function() {
+                console.log('Profile ' + entry.slot + ' sent');
+                profiles.markSent(entry.slot, entry.signature);
+                watchCoverageMask |= (1 << entry.slot);
+                sendNext(i + 1);
+            },
+            function() {
+                console.log('Failed to send profile ' + entry.slot);
+                profileSyncActive = false;
+            }
+        );
+    }
+
+    sendNext(0);
+}
+
 /**
  * Retry sending data with exponential backoff
  */
@@ -148,6 +275,12 @@ function fetchAndSendPrayerData() {
             // Save location for future cache
             location.saveLocationCache(loc);
 
+            // Switch the watch when arriving at or leaving a saved location
+            var profileSlot = profiles.detectProfileChange(loc.latitude, loc.longitude);
+            if (profileSlot >= 0) {
+                sendActiveProfile(profileSlot);
+            }
+
             // If we already sent cached data, only resend if location changed significantly
             if (cachedLoc) {
                 var latDiff = Math.abs(loc.latitude - cachedLoc.latitude);
@@ -194,28 +327,22 @@ function processPrayerData(latitude, longitude, locationName, currentSettings) {
             false  // use24Hour - let watch decide based on its settings
         );
 
+        lastResult = {
+            latitude: latitude,
+            longitude: longitude,
+            locationName: locationName,
+            rawTimes: data.rawTimes,
+            day: new Date().toDateString()
+        };
+
         // Send to watch
         sendPrayerDataToWatch(data, locationName);
 
         // Update Timeline pins
-        if (currentSettings.timelineEnabled) {
-            var tomorrowDate = new Date();
-            tomorrowDate.setDate(tomorrowDate.getDate() + 1);
-
-            var tomorrowData = prayerTimes.calculatePrayerTimes(
-                latitude,
-                longitude,
-                tomorrowDate,
-                currentSettings.calculationMethod,
-                currentSettings.asrMethod
-            );
+        updateTimeline(lastResult, currentSettings);
 
-            timeline.refreshPins(data.rawTimes, tomorrowData, {
-                reminderMinutes: currentSettings.reminderMinutes
-            }, function() {
-                console.log('Timeline pins updated');
-            });
-        }
+        // Keep the watch's precomputed profile schedules current
+        syncProfiles();
 
     } catch (e) {
         console.log('Calculation error: ' + e);
@@ -223,14 +350,134 @@ function processPrayerData(latitude, longitude, locationName, currentSettings) {
     }
 }
 
+/**
+ * Refresh Timeline pins for an already computed result
+ * @param {Object} result - Last computed result {latitude, longitude, rawTimes}
+ * @param {Object} currentSettings - Current settings
+ */
+function updateTimeline(result, currentSettings) {
+    if (!currentSettings.timelineEnabled) {
+        return;
+    }
+
+    // Pins follow the location profile active on the watch
+    var latitude = result.latitude;
+    var longitude = result.longitude;
+    var method = currentSettings.calculationMethod;
+    var asrMethod = currentSettings.asrMethod;
+    var todayData = result.rawTimes;
+
+    var active = profiles.getProfile(profiles.getActiveSlot());
+    if (active) {
+        latitude = active.latitude;
+        longitude = active.longitude;
+        method = active.calculationMethod;
+        asrMethod = active.asrMethod;
+        todayData = prayerTimes.calculatePrayerTimes(latitude, longitude,
+                                                     new Date(), method, asrMethod);
+    }
+
+    var tomorrowDate = new Date();
+    tomorrowDate.setDate(tomorrowDate.getDate() + 1);
+
+    var tomorrowData = prayerTimes.calculatePrayerTimes(
+        latitude,
+        longitude,
+        tomorrowDate,
+        method,
+        asrMethod
+    );
+
+    timeline.refreshPins(todayData, tomorrowData, {
+        reminderMinutes: currentSettings.reminderMinutes
+    }, function() {
+        console.log('Timeline pins updated');
+    });
+}
+
+/**
+ * Determine the earliest pipeline stage affected by changed settings
+ * @param {Array} changedKeys - Keys that differ from the previous settings
+ * @returns {number} STAGE value
+ */
+function classifySettingsChange(changedKeys) {
+    var stage = STAGE.NONE;
+    for (var i = 0; i < changedKeys.length; i++) {
+        var keyStage = SETTING_STAGES.hasOwnProperty(changedKeys[i]) ?
+                       SETTING_STAGES[changedKeys[i]] : STAGE.LOCATION;
+        if (keyStage > stage) {
+            stage = keyStage;
+        }
+    }
+    return stage;
+}
+
+/**
+ * Re-run only the pipeline stages affected by a settings change
+ * @param {number} stage - STAGE value from classifySettingsChange
+ * @param {Object} currentSettings - Settings after the change
+ * @param {Object} previousSettings - Settings before the change
+ */
+function applySettingsChange(stage, currentSettings, previousSettings) {
+    // Turning the timeline off must also remove the pins already pushed,
+    // since updateTimeline() does nothing while it is disabled
+    if (previousSettings.timelineEnabled && !currentSettings.timelineEnabled) {
+        console.log('Timeline disabled, removing pins');
+        timeline.removePins(function() {
+            console.log('Timeline pins removed');
+        });
+    }
+
+    // Later stages need a previous result; without one fall back to a full run
+    if (stage !== STAGE.NONE && stage < STAGE.LOCATION && !lastResult) {
+        stage = STAGE.LOCATION;
+    }
+    // Times computed on an earlier day can't be reused for pins
+    if (stage === STAGE.TIMELINE && lastResult.day !== new Date().toDateString()) {
+        stage = STAGE.TIMES;
+    }
+
+    switch (stage) {
+        case STAGE.LOCATION:
+            console.log('Location settings changed, full refresh');
+            fetchAndSendPrayerData();
+            break;
+        case STAGE.TIMES:
+            console.log('Calculation settings changed, recomputing times');
+            processPrayerData(lastResult.latitude, lastResult.longitude,
+                              lastResult.locationName, currentSettings);
+            break;
+        case STAGE.TIMELINE:
+            console.log('Timeline settings changed, updating pins only');
+            updateTimeline(lastResult, currentSettings);
+            break;
+        default:
+            console.log('No data-affecting settings changed');
+    }
+}
+
 /**
  * Handle incoming messages from watch
  */
 Pebble.addEventListener('appmessage', function(event) {
     console.log('Received message from watch');
+    var payload = event.payload;
 
-    if (event.payload[KEYS.REQUEST_DATA]) {
+    if (payload[KEYS.ACTIVE_PROFILE] !== undefined) {
+        var previousSlot = profiles.getActiveSlot();
+        profiles.setActiveSlot(payload[KEYS.ACTIVE_PROFILE]);
+
+        // A switch on the watch only needs pins for the new location
+        if (!payload[KEYS.REQUEST_DATA] && lastResult &&
+            previousSlot !== payload[KEYS.ACTIVE_PROFILE]) {
+            console.log('Watch switched to profile ' + payload[KEYS.ACTIVE_PROFILE]);
+            updateTimeline(lastResult, settings.loadSettings());
+        }
+    }
+
+    if (payload[KEYS.REQUEST_DATA]) {
         console.log('Watch requested data refresh');
+        watchCoverageMask = payload[KEYS.PROFILE_MASK] || 0;
         fetchAndSendPrayerData();
     }
 });
@@ -250,16 +497,9 @@ Pebble.addEventListener('ready', function() {
 Pebble.addEventListener('showConfiguration', function() {
     console.log('Opening configuration page');
 
-    // Get current settings for the config page
-    var currentSettings = settings.loadSettings();
-    var encoded = encodeURIComponent(JSON.stringify(currentSettings));
-
-    // Configuration page - embedded as data URI
-    var configPage = getConfigPageHtml();
-    var url = 'data:text/html;charset=utf-8,' + encodeURIComponent(configPage);
-
-    // Add current settings to URL
-    Pebble.openURL(url + '#' + encoded);
+    // Configuration page - data URI encoded at build time from config/index.html,
+    // with the current settings and their version added to the URL
+    Pebble.openURL(settings.getConfigPageUrl(configPage.CONFIG_PAGE_URL));
 });
 
 /**
@@ -269,153 +509,29 @@ Pebble.addEventListener('webviewclosed', function(event) {
     if (event && event.response) {
         console.log('Configuration closed with response');
 
-        var newSettings = settings.parseConfigUrl(event.response);
-        if (Object.keys(newSettings).length > 0) {
-            settings.updateSettings(newSettings);
-            console.log('Settings updated');
-
-            // Clear location cache if manual location changed
-            if (newSettings.manualLocation !== undefined) {
-                location.clearCache();
+        // The page returns only the keys the user changed
+        var result = settings.parseConfigResponse(event.response);
+        if (Object.keys(result.patch).length > 0) {
+            var previousSettings = settings.loadSettings();
+            var changedKeys = settings.applyPatch(result.patch, result.version);
+            if (changedKeys.length === 0) {
+                console.log('Settings unchanged');
+                return;
             }
 
-            // Refresh data with new settings
-            fetchAndSendPrayerData();
+            console.log('Settings updated: ' + changedKeys.join(', '));
+
+            // Refresh only what depends on the changed settings
+            applySettingsChange(classifySettingsChange(changedKeys), settings.loadSettings(),
+                                previousSettings);
+
+            // Saved locations only need their schedules resent
+            if (changedKeys.indexOf('profiles') !== -1) {
+                if (watchCoverageMask === null) {
+                    watchCoverageMask = 0;
+                }
+                syncProfiles();
+            }
         }
     }
 });
-
-/**
- * Get the configuration page HTML
- * Returns embedded HTML for offline use
- */
-function getConfigPageHtml() {
-    return '<!DOCTYPE html>' +
-    '<html>' +
-    '<head>' +
-    '<meta charset="utf-8">' +
-    '<meta name="viewport" content="width=device-width, initial-scale=1">' +
-    '<title>Prayer Keeper Settings</title>' +
-    '<style>' +
-    'body { font-family: -apple-system, BlinkMacSystemFont, "Segoe UI", Roboto, sans-serif; ' +
-    'background: #f5f5f5; margin: 0; padding: 20px; }' +
-    '.container { max-width: 400px; margin: 0 auto; }' +
-    'h1 { color: #333; font-size: 24px; margin-bottom: 20px; }' +
-    '.setting { background: white; border-radius: 8px; padding: 15px; margin-bottom: 15px; ' +
-    'box-shadow: 0 1px 3px rgba(0,0,0,0.1); }' +
-    '.setting label { display: block; font-weight: 600; margin-bottom: 8px; color: #333; }' +
-    '.setting select, .setting input[type="number"] { width: 100%; padding: 10px; ' +
-    'border: 1px solid #ddd; border-radius: 6px; font-size: 16px; box-sizing: border-box; }' +
-    '.setting input[type="checkbox"] { width: 20px; height: 20px; margin-right: 10px; }' +
-    '.checkbox-label { display: flex; align-items: center; font-weight: 600; color: #333; }' +
-    '.manual-inputs { margin-top: 10px; display: none; }' +
-    '.manual-inputs.show { display: block; }' +
-    '.manual-inputs input { margin-bottom: 10px; }' +
-    '.btn { display: block; width: 100%; padding: 15px; background: #00aa00; color: white; ' +
-    'border: none; border-radius: 8px; font-size: 18px; font-weight: 600; cursor: pointer; ' +
-    'margin-top: 20px; }' +
-    '.btn:hover { background: #008800; }' +
-    '.note { font-size: 12px; color: #666; margin-top: 5px; }' +
-    '</style>' +
-    '</head>' +
-    '<body>' +
-    '<div class="container">' +
-    '<h1>Prayer Keeper Settings</h1>' +
-    '<div class="setting">' +
-    '<label>Calculation Method</label>' +
-    '<select id="calculationMethod">' +
-    '<option value="mwl">Muslim World League</option>' +
-    '<option value="isna">ISNA (North America)</option>' +
-    '<option value="egyptian">Egyptian General Authority</option>' +
-    '<option value="umm_al_qura">Umm Al-Qura (Makkah)</option>' +
-    '<option value="karachi">University of Islamic Sciences, Karachi</option>' +
-    '<option value="tehran">Institute of Geophysics, Tehran</option>' +
-    '<option value="singapore">Singapore</option>' +
-    '<option value="moonsighting">Moonsighting Committee</option>' +
-    '</select>' +
-    '<p class="note">Different methods are used in different regions</p>' +
-    '</div>' +
-    '<div class="setting">' +
-    '<label>Asr Calculation</label>' +
-    '<select id="asrMethod">' +
-    '<option value="shafi">Shafi (Standard)</option>' +
-    '<option value="hanafi">Hanafi (Later)</option>' +
-    '</select>' +
-    '</div>' +
-    '<div class="setting">' +
-    '<label class="checkbox-label">' +
-    '<input type="checkbox" id="manualLocation">' +
-    'Use Manual Location' +
-    '</label>' +
-    '<div class="manual-inputs" id="manualInputs">' +
-    '<input type="number" step="any" id="manualLatitude" placeholder="Latitude (e.g., 51.5074)">' +
-    '<input type="number" step="any" id="manualLongitude" placeholder="Longitude (e.g., -0.1278)">' +
-    '</div>' +
-    '</div>' +
-    '<div class="setting">' +
-    '<label class="checkbox-label">' +
-    '<input type="checkbox" id="timelineEnabled" checked>' +
-    'Enable Timeline Pins' +
-    '</label>' +
-    '<p class="note">Show prayer times in Pebble Timeline</p>' +
-    '</div>' +
-    '<div class="setting">' +
-    '<label>Reminder Time</label>' +
-    '<select id="reminderMinutes">' +
-    '<option value="5">5 minutes before</option>' +
-    '<option value="10" selected>10 minutes before</option>' +
-    '<option value="15">15 minutes before</option>' +
-    '<option value="20">20 minutes before</option>' +
-    '<option value="30">30 minutes before</option>' +
-    '</select>' +
-    '</div>' +
-    '<div class="setting">' +
-    '<label class="checkbox-label">' +
-    '<input type="checkbox" id="vibrationEnabled" checked>' +
-    'Vibrate at Prayer Time' +
-    '</label>' +
-    '</div>' +
-    '<button class="btn" onclick="saveSettings()">Save Settings</button>' +
-    '</div>' +
-    '<script>' +
-    'function loadSettings() {' +
-    '  var hash = window.location.hash.substring(1);' +
-    '  if (hash) {' +
-    '    try {' +
-    '      var settings = JSON.parse(decodeURIComponent(hash));' +
-    '      if (settings.calculationMethod) document.getElementById("calculationMethod").value = settings.calculationMethod;' +
-    '      if (settings.asrMethod) document.getElementById("asrMethod").value = settings.asrMethod;' +
-    '      document.getElementById("manualLocation").checked = settings.manualLocation || false;' +
-    '      if (settings.manualLatitude) document.getElementById("manualLatitude").value = settings.manualLatitude;' +
-    '      if (settings.manualLongitude) document.getElementById("manualLongitude").value = settings.manualLongitude;' +
-    '      document.getElementById("timelineEnabled").checked = settings.timelineEnabled !== false;' +
-    '      if (settings.reminderMinutes) document.getElementById("reminderMinutes").value = settings.reminderMinutes;' +
-    '      document.getElementById("vibrationEnabled").checked = settings.vibrationEnabled !== false;' +
-    '      toggleManualInputs();' +
-    '    } catch(e) { console.log("Error loading settings: " + e); }' +
-    '  }' +
-    '}' +
-    'function toggleManualInputs() {' +
-    '  var show = document.getElementById("manualLocation").checked;' +
-    '  document.getElementById("manualInputs").className = "manual-inputs" + (show ? " show" : "");' +
-    '}' +
-    'document.getElementById("manualLocation").addEventListener("change", toggleManualInputs);' +
-    'function saveSettings() {' +
-    '  var settings = {' +
-    '    calculationMethod: document.getElementById("calculationMethod").value,' +
-    '    asrMethod: document.getElementById("asrMethod").value,' +
-    '    manualLocation: document.getElementById("manualLocation").checked,' +
-    '    manualLatitude: parseFloat(document.getElementById("manualLatitude").value) || 0,' +
-    '    manualLongitude: parseFloat(document.getElementById("manualLongitude").value) || 0,' +
-    '    timelineEnabled: document.getElementById("timelineEnabled").checked,' +
-    '    reminderMinutes: parseInt(document.getElementById("reminderMinutes").value),' +
-    '    vibrationEnabled: document.getElementById("vibrationEnabled").checked' +
-    '  };' +
-    '  var encoded = encodeURIComponent(JSON.stringify(settings));' +
-    '  window.location.href = "pebblejs://close#" + encoded;' +
-    '}' +
-    'loadSettings();' +
-    '</script>' +
-    '</body>' +
-    '</html>';
-}
@@ -0,0 +1,365 @@
+/**
+ * Location Profiles Module
+ * Named locations with precomputed multi-day schedules for the watch
+ */
+
+var prayerTimes = require('./prayer_times');
+var settings = require('./settings');
+
+// Slot 0 is the current (GPS or manual) location, named profiles follow
+var MAX_PROFILES = 3;
+var CURRENT_SLOT = 0;
+
+// Days of prayer times sent per profile (must match PROFILE_SCHEDULE_DAYS)
+var SCHEDULE_DAYS = 30;
+
+// Longest name the watch stores, in UTF-8 bytes (LocationProfile.name minus NUL)
+var NAME_MAX_BYTES = 31;
+
+// Distance within which a named profile is considered "here"
+var PROXIMITY_KM = 2;
+
+// localStorage keys
+var SENT_KEY = 'prayerkeeper_profiles_sent';
+var ACTIVE_KEY = 'prayerkeeper_active_profile';
+var NEARBY_KEY = 'prayerkeeper_nearby_profile';
+
+// Kaaba coordinates for the Qibla bearing
+var KAABA_LATITUDE = 21.4225;
+var KAABA_LONGITUDE = 39.8262;
+
+// Prayer order in the packed schedule (matches PrayerIndex on the watch)
+var PRAYER_ORDER = ['fajr', 'sunrise', 'dhuhr', 'asr', 'maghrib', 'isha'];
+
+/**
+ * Truncate a string to a UTF-8 byte length without splitting a character
+ * The watch copies names byte by byte, so a character cut by length
+ * alone could leave half a multi-byte sequence at the end.
+ * @param {string} text - Text to truncate
+ * @param {number} maxBytes - Maximum encoded length
+ * @returns {string} Truncated text
+ */
+function truncateUtf8(text, maxBytes) {
+    var bytes = 0;
+    for (var i = 0; i < text.length; i++) {
+        var code = text.charCodeAt(i);
+        var units = 1;
+        var size;
+
+        if (code >= 0xd800 && code <= 0xdbff && i + 1 < text.length) {
+            // Surrogate pair - one 4-byte character
+            units = 2;
+            size = 4;
+        } else if (code >= 0x800) {
+            size = 3;
+        } else if (code >= 0x80) {
+            size = 2;
+        } else {
+            size = 1;
+        }
+
+        if (bytes + size > maxBytes) {
+            return text.substring(0, i);
+        }
+        bytes += size;
+        i += units - 1;
+    }
+    return text;
+}
+
+/**
+ * Get the named profiles from settings, mapped to watch slots
+ * @returns {Array} Profiles {slot, name, latitude, longitude, calculationMethod, asrMethod}
+ */
+function getNamedProfiles() {
+    var currentSettings = settings.loadSettings();
+    var stored = currentSettings.profiles || [];
+    var profiles = [];
+
+    for (var i = 0; i < stored.length && i < MAX_PROFILES - 1; i++) {
+        var p = stored[i];
+        if (!p || !p.name || (p.latitude === 0 && p.longitude === 0)) {
+            continue;
+        }
+        profiles.push({
+            slot: i + 1,
+            name: truncateUtf8(p.name, NAME_MAX_BYTES),
+            latitude: p.latitude,
+            longitude: p.longitude,
+            calculationMethod: p.calculationMethod || currentSettings.calculationMethod,
+            asrMethod: p.asrMethod || currentSettings.asrMethod
+        });
+    }
+    return profiles;
+}
+
+/**
+ * Get the profile occupying a slot
+ * @param {number} slot - Watch slot
+ * @returns {Object|null} Profile or null
+ */
+function getProfile(slot) {
+    var profiles = getNamedProfiles();
+    for (var i = 0; i < profiles.length; i++) {
+        if (profiles[i].slot === slot) {
+            return profiles[i];
+        }
+    }
+    return null;
+}
+
+/**
+ * Signature of the inputs a schedule depends on (excluding the start day)
+ * Schedules are in local time, so a timezone change needs a resend too.
+ * @param {Object} profile - Profile
+ * @returns {string} Signature
+ */
+function getSignature(profile) {
+    return [
+        profile.name,
+        new Date().getTimezoneOffset(),
+        profile.latitude.toFixed(2),
+        profile.longitude.toFixed(2),
+        profile.calculationMethod,
+        profile.asrMethod
+    ].join('|');
+}
+
+/**
+ * Compute a packed schedule of minutes since midnight
+ * @param {Object} profile - Profile with coordinates and methods
+ * @param {Date} startDate - Local midnight of the first day
+ * @returns {Array} Little-endian int16 bytes, SCHEDULE_DAYS x 6 prayers
+ */
+function buildSchedule(profile, startDate) {
+    var bytes = [];
+    var date = new Date(startDate.getTime());
+
+    for (var day = 0; day < SCHEDULE_DAYS; day++) {
+        var times = prayerTimes.calculatePrayerTimes(
+            profile.latitude,
+            profile.longitude,
+            date,
+            profile.calculationMethod,
+            profile.asrMethod
+        );
+
+        for (var i = 0; i < PRAYER_ORDER.length; i++) {
+            var minutes = prayerTimes.dateToMinutes(times[PRAYER_ORDER[i]]);
+            bytes.push(minutes & 0xff, (minutes >> 8) & 0xff);
+        }
+        date.setDate(date.getDate() + 1);
+    }
+    return bytes;
+}
+
+/**
+ * Great-circle initial bearing from a location to the Kaaba
+ * @param {number} latitude - Latitude in degrees
+ * @param {number} longitude - Longitude in degrees
+ * @returns {number} Bearing as a Pebble trig angle (0-65535, clockwise from true north)
+ */
+function getQiblaAngle(latitude, longitude) {
+    var toRad = Math.PI / 180;
+    var lat = latitude * toRad;
+    var kaabaLat = KAABA_LATITUDE * toRad;
+    var dLon = (KAABA_LONGITUDE - longitude) * toRad;
+
+    var bearing = Math.atan2(
+        Math.sin(dLon),
+        Math.cos(lat) * Math.tan(kaabaLat) - Math.sin(lat) * Math.cos(dLon)
+    );
+    var degrees = (bearing / toRad + 360) % 360;
+    return Math.round(degrees / 360 * 65536) & 0xffff;
+}
+
+/**
+ * Build the AppMessage payload fields for a profile slot
+ * @param {Object|null} profile - Profile, or null to clear the slot
+ * @returns {Object} {name, start, qibla, schedule} (empty when clearing)
+ */
+function buildPayload(profile) {
+    if (!profile) {
+        return {};
+    }
+
+    var today = new Date();
+    today.setHours(0, 0, 0, 0);
+
+    return {
+        name: profile.name,
+        start: Math.floor(today.getTime() / 1000),
+        qibla: getQiblaAngle(profile.latitude, profile.longitude),
+        schedule: buildSchedule(profile, today)
+    };
+}
+
+/**
+ * Load the signatures of schedules last sent to the watch
+ * @returns {Object} Map of slot -> signature
+ */
+function loadSent() {
+    try {
+        return JSON.parse(localStorage.getItem(SENT_KEY)) || {};
+    } catch (e) {
+        return {};
+    }
+}
+
+/**
+ * Record that a slot's schedule was sent
+ * @param {number} slot - Watch slot
+ * @param {string|null} signature - Signature sent, or null if cleared
+ */
+function markSent(slot, signature) {
+    var sent = loadSent();
+    if (signature) {
+        sent[slot] = signature;
+    } else {
+        delete sent[slot];
+    }
+    try {
+        localStorage.setItem(SENT_KEY, JSON.stringify(sent));
+    } catch (e) {
+        console.log('Error saving profile state: ' + e);
+    }
+}
+
+/**
+ * Decide which slots need sending to the watch
+ * @param {Object} current - Current location profile for slot 0 (or null)
+ * @param {number} coverageMask - Slots the watch reports as still covered
+ * @returns {Array} Entries {slot, profile, signature} (profile null = clear)
+ */
+function getPendingSlots(current, coverageMask) {
+    var sent = loadSent();
+    var pending = [];
+    var bySlot = {};
+
+    if (current) {
+        bySlot[CURRENT_SLOT] = current;
+    }
+    getNamedProfiles().forEach(function(p) {
+        bySlot[p.slot] = p;
+    });
+
+    for (var slot = 0; slot < MAX_PROFILES; slot++) {
+        var profile = bySlot[slot] || null;
+        var signature = profile ? getSignature(profile) : null;
+        var covered = (coverageMask & (1 << slot)) !== 0;
+
+        if (profile && (!covered || sent[slot] !== signature)) {
+            pending.push({ slot: slot, profile: profile, signature: signature });
+        } else if (!profile && sent[slot] && slot !== CURRENT_SLOT) {
+            // Profile was removed on the phone
+            pending.push({ slot: slot, profile: null, signature: null });
+        }
+    }
+    return pending;
+}
+
+/**
+ * Great-circle distance between two coordinates
+ * @returns {number} Distance in kilometres
+ */
+function distanceKm(lat1, lon1, lat2, lon2) {
+    var toRad = Math.PI / 180;
+    var dLat = (lat2 - lat1) * toRad;
+    var dLon = (lon2 - lon1) * toRad;
+    var a = Math.sin(dLat / 2) * Math.sin(dLat / 2) +
+            Math.cos(lat1 * toRad) * Math.cos(lat2 * toRad) *
+            Math.sin(dLon / 2) * Math.sin(dLon / 2);
+    return 6371 * 2 * Math.atan2(Math.sqrt(a), Math.sqrt(1 - a));
+}
+
+/**
+ * Find the named profile the user is currently at
+ * @param {number} latitude - Current latitude
+ * @param {number} longitude - Current longitude
+ * @returns {number} Slot of the nearby profile, or CURRENT_SLOT if none
+ */
+function findNearbySlot(latitude, longitude) {
+    var profiles = getNamedProfiles();
+    var best = CURRENT_SLOT;
+    var bestDistance = PROXIMITY_KM;
+
+    for (var i = 0; i < profiles.length; i++) {
+        var d = distanceKm(latitude, longitude, profiles[i].latitude, profiles[i].longitude);
+        if (d < bestDistance) {
+            best = profiles[i].slot;
+            bestDistance = d;
+        }
+    }
+    return best;
+}
+
+/**
+ * Detect arriving at or leaving a named profile's location
+ * Only reports changes, so a manual switch on the watch is left alone
+ * until the user actually moves.
+ * @param {number} latitude - Current latitude
+ * @param {number} longitude - Current longitude
+ * @returns {number} Slot to switch to, or -1 for no change
+ */
+function detectProfileChange(latitude, longitude) {
+    var nearby = findNearbySlot(latitude, longitude);
+    var stored = parseInt(localStorage.getItem(NEARBY_KEY), 10);
+    var last = isNaN(stored) ? -1 : stored;
+
+    if (nearby === last) {
+        return -1;
+    }
+
+    try {
+        localStorage.setItem(NEARBY_KEY, String(nearby));
+    } catch (e) {
+        console.log('Error saving nearby profile: ' + e);
+    }
+
+    if (nearby !== CURRENT_SLOT) {
+        return nearby;
+    }
+    // Left the place that was auto-selected - go back to current location
+    return (getActiveSlot() === last) ? CURRENT_SLOT : -1;
+}
+
+/**
+ * Get the slot last reported active by the watch
+ * @returns {number} Active slot
+ */
+function getActiveSlot() {
+    var stored = parseInt(localStorage.getItem(ACTIVE_KEY), 10);
+    return isNaN(stored) ? CURRENT_SLOT : stored;
+}
+
+/**
+ * Record the active slot
+ * @param {number} slot - Active slot
+ */
+function setActiveSlot(slot) {
+    try {
+        localStorage.setItem(ACTIVE_KEY, String(slot));
+    } catch (e) {
+        console.log('Error saving active profile: ' + e);
+    }
+}
+
+// Export module
+module.exports = {
+    truncateUtf8: truncateUtf8,
+    getNamedProfiles: getNamedProfiles,
+    getProfile: getProfile,
+    getSignature: getSignature,
+    buildSchedule: buildSchedule,
+    buildPayload: buildPayload,
+    getQiblaAngle: getQiblaAngle,
+    getPendingSlots: getPendingSlots,
+    markSent: markSent,
+    findNearbySlot: findNearbySlot,
+    detectProfileChange: detectProfileChange,
+    getActiveSlot: getActiveSlot,
+    setActiveSlot: setActiveSlot,
+    MAX_PROFILES: MAX_PROFILES,
+    NAME_MAX_BYTES: NAME_MAX_BYTES,
+    CURRENT_SLOT: CURRENT_SLOT
+};
@@ -12,43 +12,94 @@ var DEFAULT_SETTINGS = {
     manualLongitude: 0,
     timelineEnabled: true,
     reminderMinutes: 10,
-    vibrationEnabled: true
+    vibrationEnabled: true,
+    profiles: []    // Named locations [{name, latitude, longitude, calculationMethod?, asrMethod?}]
 };
 
 // Settings keys for localStorage
 var SETTINGS_KEY = 'prayerkeeper_settings';
 
+// Fields holding version metadata inside the stored object, so the
+// versions and the values are always written together
+var VERSION_FIELD = '_version';     // Bumped on every save
+var MODIFIED_FIELD = '_modified';   // Version at which each key last changed
+
 /**
- * Load settings from localStorage
- * @returns {Object} Current settings
+ * Read the stored settings object (including its version field)
+ * @returns {Object} Stored settings, or an empty object
  */
-function loadSettings() {
+function loadStored() {
     try {
         var stored = localStorage.getItem(SETTINGS_KEY);
         if (stored) {
-            var settings = JSON.parse(stored);
-            // Merge with defaults to handle new settings
-            return Object.assign({}, DEFAULT_SETTINGS, settings);
+            return JSON.parse(stored);
         }
     } catch (e) {
         console.log('Error loading settings: ' + e);
     }
-    return Object.assign({}, DEFAULT_SETTINGS);
+    return {};
 }
 
 /**
- * Save settings to localStorage
+ * Get the settings from a stored object, without its version metadata
+ * @param {Object} stored - Stored settings object
+ * @returns {Object} Settings
+ */
+function toSettings(stored) {
+    // Merge with defaults to handle new settings
+    var settings = Object.assign({}, DEFAULT_SETTINGS, stored);
+    delete settings[VERSION_FIELD];
+    delete settings[MODIFIED_FIELD];
+    return settings;
+}
+
+/**
+ * Load settings from localStorage
+ * @returns {Object} Current settings
+ */
+function loadSettings() {
+    return toSettings(loadStored());
+}
+
+/**
+ * Get the version of the stored settings (bumped on every save)
+ * @returns {number} Settings version
+ */
+function getSettingsVersion() {
+    return loadStored()[VERSION_FIELD] || 0;
+}
+
+/**
+ * Save settings as the next version of an already loaded stored object
+ * @param {Object} stored - Stored object the settings were derived from
  * @param {Object} settings - Settings to save
  */
-function saveSettings(settings) {
+function writeSettings(stored, settings) {
+    var version = (stored[VERSION_FIELD] || 0) + 1;
+    var modified = Object.assign({}, stored[MODIFIED_FIELD]);
+    diffSettings(toSettings(stored), settings).forEach(function(key) {
+        modified[key] = version;
+    });
+
     try {
-        localStorage.setItem(SETTINGS_KEY, JSON.stringify(settings));
+        var data = Object.assign({}, settings);
+        data[VERSION_FIELD] = version;
+        data[MODIFIED_FIELD] = modified;
+        localStorage.setItem(SETTINGS_KEY, JSON.stringify(data));
         console.log('Settings saved');
     } catch (e) {
         console.log('Error saving settings: ' + e);
     }
 }
 
+/**
+ * Save settings to localStorage
+ * @param {Object} settings - Settings to save
+ */
+function saveSettings(settings) {
+    writeSettings(loadStored(), settings);
+}
+
 /**
  * Get a single setting value
  * @param {string} key - Setting key
@@ -65,9 +116,10 @@ function getSetting(key) {
  * @param {*} value - Setting value
  */
 function setSetting(key, value) {
-    var settings = loadSettings();
+    var stored = loadStored();
+    var settings = toSettings(stored);
     settings[key] = value;
-    saveSettings(settings);
+    writeSettings(stored, settings);
 }
 
 /**
@@ -75,16 +127,82 @@ function setSetting(key, value) {
  * @param {Object} updates - Settings to update
  */
 function updateSettings(updates) {
-    var settings = loadSettings();
+    var stored = loadStored();
+    var settings = toSettings(stored);
     Object.assign(settings, updates);
-    saveSettings(settings);
+    writeSettings(stored, settings);
+}
+
+/**
+ * List the keys whose values differ between two settings objects
+ * @param {Object} oldSettings - Previous settings
+ * @param {Object} newSettings - Updated settings
+ * @returns {Array} Changed setting keys
+ */
+function diffSettings(oldSettings, newSettings) {
+    var changed = [];
+    for (var key in newSettings) {
+        if (!newSettings.hasOwnProperty(key)) {
+            continue;
+        }
+        var newValue = newSettings[key];
+        var oldValue = oldSettings[key];
+        // Compare structured values (e.g. profiles) by content
+        if (typeof newValue === 'object' && newValue !== null) {
+            if (JSON.stringify(newValue) !== JSON.stringify(oldValue)) {
+                changed.push(key);
+            }
+        } else if (newValue !== oldValue) {
+            changed.push(key);
+        }
+    }
+    return changed;
+}
+
+/**
+ * Apply a patch of changed settings in a single write
+ * Unknown keys and values equal to the stored ones are ignored. Keys are
+ * merged one by one: a key saved after baseVersion keeps the newer stored
+ * value, so a page opened on an older version can't revert it.
+ * @param {Object} patch - Changed settings from the configuration page
+ * @param {number} baseVersion - Settings version the page was opened with
+ * @returns {Array} Keys that actually changed
+ */
+function applyPatch(patch, baseVersion) {
+    var stored = loadStored();
+    var settings = toSettings(stored);
+    var modified = stored[MODIFIED_FIELD] || {};
+    var updates = {};
+
+    for (var key in patch) {
+        if (!patch.hasOwnProperty(key) || !DEFAULT_SETTINGS.hasOwnProperty(key)) {
+            continue;
+        }
+        if (baseVersion !== undefined && (modified[key] || 0) > baseVersion) {
+            console.log('Keeping newer ' + key + ' (changed in version ' + modified[key] +
+                        ', page opened on ' + baseVersion + ')');
+            continue;
+        }
+        updates[key] = patch[key];
+    }
+
+    var changed = diffSettings(settings, updates);
+    if (changed.length === 0) {
+        return changed;
+    }
+
+    for (var i = 0; i < changed.length; i++) {
+        settings[changed[i]] = updates[changed[i]];
+    }
+    writeSettings(stored, settings);
+    return changed;
 }
 
 /**
  * Reset settings to defaults
  */
 function resetSettings() {
-    saveSettings(Object.assign({}, DEFAULT_SETTINGS));
+    writeSettings(loadStored(), Object.assign({}, DEFAULT_SETTINGS));
 }
 
 /**
@@ -102,12 +220,12 @@ function parseConfigUrl(configUrl) {
             hashIndex = configUrl.indexOf('?');
         }
 
-        if (hashIndex === -1) {
+        // webviewclosed responses carry the data without a prefix
+        var configData = (hashIndex === -1) ? configUrl : configUrl.substring(hashIndex + 1);
+        if (!configData) {
             return settings;
         }
 
-        var configData = configUrl.substring(hashIndex + 1);
-
         // Try to decode as JSON first (our format)
         try {
             var decoded = decodeURIComponent(configData);
@@ -137,15 +255,29 @@ function parseConfigUrl(configUrl) {
     return settings;
 }
 
+/**
+ * Parse a configuration page response into a settings patch
+ * Accepts the compact {v, p} patch format as well as a full settings object.
+ * @param {string} response - Response from the configuration page
+ * @returns {Object} {patch, version} (version undefined for full settings)
+ */
+function parseConfigResponse(response) {
+    var data = parseConfigUrl(response);
+    if (data.p && typeof data.p === 'object') {
+        return { patch: data.p, version: data.v };
+    }
+    return { patch: data, version: undefined };
+}
+
 /**
  * Get the configuration page URL with current settings
  * @param {string} baseUrl - Base configuration page URL
- * @returns {string} URL with settings data
+ * @returns {string} URL with versioned settings data {v, s}
  */
 function getConfigPageUrl(baseUrl) {
-    var settings = loadSettings();
-    var encoded = encodeURIComponent(JSON.stringify(settings));
-    return baseUrl + '#' + encoded;
+    var stored = loadStored();
+    var payload = { v: stored[VERSION_FIELD] || 0, s: toSettings(stored) };
+    return baseUrl + '#' + encodeURIComponent(JSON.stringify(payload));
 }
 
 // Export module
@@ -155,8 +287,12 @@ module.exports = {
     getSetting: getSetting,
     setSetting: setSetting,
     updateSettings: updateSettings,
+    diffSettings: diffSettings,
+    applyPatch: applyPatch,
+    getSettingsVersion: getSettingsVersion,
     resetSettings: resetSettings,
     parseConfigUrl: parseConfigUrl,
+    parseConfigResponse: parseConfigResponse,
     getConfigPageUrl: getConfigPageUrl,
     DEFAULT_SETTINGS: DEFAULT_SETTINGS
 };
@@ -157,6 +157,26 @@ function deletePin(pinId, callback) {
     request.send();
 }
 
+/**
+ * Delete the pins for all prayers on a given day
+ * @param {Date} date - Day the pins were created for
+ * @param {function} callback - Called when all deletes complete
+ */
+function deleteDayPins(date, callback) {
+    var dateStr = formatDateForId(date);
+    var completed = 0;
+    var total = PRAYER_NAMES.length;
+
+    PRAYER_NAMES.forEach(function(prayerName) {
+        deletePin(PIN_PREFIX + prayerName + '-' + dateStr, function(success) {
+            completed++;
+            if (completed === total && callback) {
+                callback();
+            }
+        });
+    });
+}
+
 /**
  * Create pins for all prayers for a given day
  * @param {Object} prayerTimes - Prayer times object with Date values
@@ -245,12 +265,27 @@ function refreshPins(todayTimes, tomorrowTimes, options, callback) {
     });
 }
 
+/**
+ * Remove the pins created by refreshPins (today and tomorrow)
+ * @param {function} callback - Called when complete
+ */
+function removePins(callback) {
+    var tomorrow = new Date();
+    tomorrow.setDate(tomorrow.getDate() + 1);
+
+    deleteDayPins(new Date(), function() {
+        deleteDayPins(tomorrow, callback);
+    });
+}
+
 // Export module
 module.exports = {
     createPrayerPin: createPrayerPin,
     insertPin: insertPin,
     deletePin: deletePin,
+    deleteDayPins: deleteDayPins,
     createDayPins: createDayPins,
     refreshPins: refreshPins,
+    removePins: removePins,
     PIN_PREFIX: PIN_PREFIX
 };
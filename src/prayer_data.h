@@ -18,7 +18,8 @@ typedef struct {
     int16_t times[PRAYER_COUNT];     // Minutes since midnight for each prayer
     char next_prayer_name[16];        // Name of next prayer
     char next_prayer_time[16];        // Formatted time string
-    int32_t countdown_seconds;        // Seconds until next prayer
+    int32_t countdown_seconds;        // Seconds until next prayer (as of last tick)
+    uint32_t next_prayer_epoch;       // Absolute time of next prayer
     char location_name[32];           // Location display name
     bool data_valid;                  // Whether we have valid data
     int8_t error_code;                // 0 = success, >0 = error
@@ -31,11 +32,22 @@ typedef struct {
 // Persistent storage keys
 #define STORAGE_KEY_PRAYER_DATA 1
 #define STORAGE_KEY_VERSION 2
-#define STORAGE_VERSION 1
+#define STORAGE_KEY_ACTIVE_PROFILE 3
+#define STORAGE_KEY_PROFILE_BASE 10     // Location profiles use keys 10..21
+#define STORAGE_VERSION 3
 
 // Global prayer data instance
 extern PrayerData g_prayer_data;
 
+// Display name of a prayer (e.g. "Dhuhr")
+const char* prayer_data_get_name(PrayerIndex index);
+
+// Get the current prayer (the one before next prayer)
+PrayerIndex prayer_data_get_current(PrayerIndex next);
+
+// Seconds remaining until the next prayer, derived from the absolute epoch
+int32_t prayer_data_seconds_remaining(void);
+
 // Helper function to format minutes since midnight to time string
 void format_time_from_minutes(int16_t minutes, char* buffer, size_t buffer_size);
 
@@ -3,6 +3,7 @@
 #include "prayer_data.h"
 #include "prayer_list.h"
 #include "message_handler.h"
+#include "location_profiles.h"
 
 // Window and layers
 static Window *s_main_window;
@@ -16,6 +17,9 @@ static TextLayer *s_hint_layer;
 // Buffers for display text
 static char s_countdown_buffer[32];
 
+// One-shot timer for the next prayer (replaces polling in the tick handler)
+static AppTimer *s_transition_timer;
+
 // Format minutes since midnight to readable time
 void format_time_from_minutes(int16_t minutes, char* buffer, size_t buffer_size) {
     if (minutes < 0) {
@@ -36,14 +40,54 @@ void format_time_from_minutes(int16_t minutes, char* buffer, size_t buffer_size)
     }
 }
 
-// Update countdown display (called every second)
-void prayer_display_update_countdown(void) {
+// Fires at the exact time of the next prayer
+static void transition_timer_callback(void *data) {
+    s_transition_timer = NULL;
+    g_prayer_data.countdown_seconds = 0;
+
+    // Vibrate for prayer time unless quiet time is on
+    if (!quiet_time_is_active()) {
+        // Double vibration pattern for prayer time
+        static const uint32_t segments[] = {200, 100, 200, 100, 400};
+        VibePattern pattern = {
+            .durations = segments,
+            .num_segments = ARRAY_LENGTH(segments)
+        };
+        vibes_enqueue_custom_pattern(pattern);
+    }
+
+    // Advance from the precomputed schedule when possible; otherwise
+    // request fresh data from phone, even in quiet time, or the next
+    // prayer would never be picked up
+    if (location_profiles_apply()) {
+        prayer_display_update();
+    } else {
+        message_handler_request_data();
+    }
+}
+
+// (Re)arm the one-shot timer for the next prayer transition
+static void schedule_transition_timer(void) {
+    if (s_transition_timer) {
+        app_timer_cancel(s_transition_timer);
+        s_transition_timer = NULL;
+    }
+
     if (!g_prayer_data.data_valid) return;
 
-    // Decrement countdown each second
-    if (g_prayer_data.countdown_seconds > 0) {
-        g_prayer_data.countdown_seconds--;
+    int32_t remaining = prayer_data_seconds_remaining();
+    if (remaining > 0) {
+        s_transition_timer = app_timer_register((uint32_t)remaining * 1000,
+                                                transition_timer_callback, NULL);
     }
+}
+
+// Update countdown display (called every second while visible)
+void prayer_display_update_countdown(void) {
+    if (!g_prayer_data.data_valid) return;
+
+    // Derive countdown from the absolute prayer time
+    g_prayer_data.countdown_seconds = prayer_data_seconds_remaining();
 
     // Format countdown with hours, minutes, seconds
     int32_t total_seconds = g_prayer_data.countdown_seconds;
@@ -58,20 +102,6 @@ void prayer_display_update_countdown(void) {
     }
 
     text_layer_set_text(s_countdown_layer, s_countdown_buffer);
-
-    // Check if prayer time arrived - vibrate if enabled
-    if (g_prayer_data.countdown_seconds == 0 && !quiet_time_is_active()) {
-        // Double vibration pattern for prayer time
-        static const uint32_t segments[] = {200, 100, 200, 100, 400};
-        VibePattern pattern = {
-            .durations = segments,
-            .num_segments = ARRAY_LENGTH(segments)
-        };
-        vibes_enqueue_custom_pattern(pattern);
-
-        // Request fresh data from phone
-        message_handler_request_data();
-    }
 }
 
 // Update display with new data
@@ -107,8 +137,9 @@ void prayer_display_update(void) {
     text_layer_set_text(s_next_prayer_name_layer, g_prayer_data.next_prayer_name);
     text_layer_set_text(s_next_prayer_time_layer, g_prayer_data.next_prayer_time);
 
-    // Update countdown
+    // Update countdown and arm the transition timer
     prayer_display_update_countdown();
+    schedule_transition_timer();
 
     // Update hint
     text_layer_set_text(s_hint_layer, "DOWN for all times");
@@ -120,6 +151,7 @@ void prayer_display_update(void) {
 // Button click handler - SELECT to refresh
 static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
     g_prayer_data.data_valid = false;
+    schedule_transition_timer();
     g_prayer_data.error_code = 0;
     text_layer_set_text(s_location_layer, "Refreshing...");
     text_layer_set_text(s_next_label_layer, "");
@@ -130,6 +162,18 @@ static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
     message_handler_request_data();
 }
 
+// Up button handler - switch to the next location profile
+static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+    if (!location_profiles_cycle()) {
+        return;
+    }
+
+    if (location_profiles_apply()) {
+        prayer_display_update();
+    }
+    message_handler_send_active_profile();
+}
+
 // Down button handler - show prayer list
 static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
     window_stack_push(prayer_list_get_window(), true);
@@ -137,6 +181,7 @@ static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
 
 // Click config provider
 static void click_config_provider(void *context) {
+    window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
     window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
     window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
 }
@@ -205,15 +250,21 @@ static void window_load(Window *window) {
     text_layer_set_font(s_hint_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
     text_layer_set_text_alignment(s_hint_layer, GTextAlignmentCenter);
     layer_add_child(window_layer, text_layer_get_layer(s_hint_layer));
+}
 
-    // Subscribe to tick timer - SECOND_UNIT for countdown
+// Window appear handler - the countdown only ticks while it is on screen
+static void window_appear(Window *window) {
+    prayer_display_update_countdown();
     tick_timer_service_subscribe(SECOND_UNIT, tick_handler);
 }
 
-// Window unload handler
-static void window_unload(Window *window) {
+// Window disappear handler - stop per-second wakeups while hidden
+static void window_disappear(Window *window) {
     tick_timer_service_unsubscribe();
+}
 
+// Window unload handler
+static void window_unload(Window *window) {
     text_layer_destroy(s_location_layer);
     text_layer_destroy(s_next_label_layer);
     text_layer_destroy(s_next_prayer_name_layer);
@@ -229,11 +280,17 @@ void prayer_display_init(void) {
     window_set_click_config_provider(s_main_window, click_config_provider);
     window_set_window_handlers(s_main_window, (WindowHandlers) {
         .load = window_load,
+        .appear = window_appear,
+        .disappear = window_disappear,
         .unload = window_unload
     });
 }
 
 void prayer_display_deinit(void) {
+    if (s_transition_timer) {
+        app_timer_cancel(s_transition_timer);
+        s_transition_timer = NULL;
+    }
     window_destroy(s_main_window);
 }
 
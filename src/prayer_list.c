@@ -2,6 +2,8 @@
 #include "prayer_list.h"
 #include "prayer_data.h"
 #include "prayer_display.h"
+#include "prayer_month.h"
+#include "prayer_qibla.h"
 
 // Window and layers
 static Window *s_list_window;
@@ -11,6 +13,27 @@ static Layer *s_canvas_layer;
 static const char* DISPLAY_NAMES[] = {"Fajr", "Dhuhr", "Asr", "Maghrib", "Isha"};
 static const PrayerIndex DISPLAY_INDICES[] = {PRAYER_FAJR, PRAYER_DHUHR, PRAYER_ASR, PRAYER_MAGHRIB, PRAYER_ISHA};
 
+// Row layout, computed once per window load
+typedef struct {
+    int16_t title_y;
+    int16_t start_y;
+    int16_t row_height;
+    int16_t x_padding;
+    int16_t column_width;
+    int16_t hint_x;
+    int16_t hint_y;
+} ListLayout;
+
+static ListLayout s_layout;
+
+// Fonts, looked up once per window load
+static GFont s_title_font;
+static GFont s_time_font;
+static GFont s_hint_font;
+
+// Formatted times, rebuilt only when the data changes
+static char s_time_buffers[ARRAY_LENGTH(DISPLAY_INDICES)][16];
+
 // Format time for display
 static void format_prayer_time(int16_t minutes, char* buffer, size_t size) {
     if (minutes < 0) {
@@ -31,46 +54,40 @@ static void format_prayer_time(int16_t minutes, char* buffer, size_t size) {
     }
 }
 
+// Rebuild the formatted time strings from the current data
+static void format_all_times(void) {
+    for (size_t i = 0; i < ARRAY_LENGTH(DISPLAY_INDICES); i++) {
+        format_prayer_time(g_prayer_data.times[DISPLAY_INDICES[i]],
+                           s_time_buffers[i], sizeof(s_time_buffers[i]));
+    }
+}
+
 // Canvas drawing callback
+// The window background is already black, so only text and the highlight are drawn
 static void canvas_update_proc(Layer *layer, GContext *ctx) {
     GRect bounds = layer_get_bounds(layer);
-    bool is_round = PBL_IF_ROUND_ELSE(true, false);
 
     // Colors
-    GColor bg_color = GColorBlack;
     GColor text_color = GColorWhite;
     GColor highlight_bg = PBL_IF_COLOR_ELSE(GColorDarkGreen, GColorWhite);
     GColor highlight_text = PBL_IF_COLOR_ELSE(GColorWhite, GColorBlack);
 
-    // Clear background
-    graphics_context_set_fill_color(ctx, bg_color);
-    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
-
     // Header
     graphics_context_set_text_color(ctx, text_color);
-    const char *title = "Prayer Times";
-    GRect title_rect = GRect(0, is_round ? 12 : 4, bounds.size.w, 20);
-    graphics_draw_text(ctx, title, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+    GRect title_rect = GRect(0, s_layout.title_y, bounds.size.w, 20);
+    graphics_draw_text(ctx, "Prayer Times", s_title_font,
                        title_rect, GTextOverflowModeTrailingEllipsis,
                        GTextAlignmentCenter, NULL);
 
-    // Calculate row dimensions
-    int start_y = is_round ? 38 : 28;
-    int row_height = is_round ? 26 : 24;
-    int x_padding = is_round ? 25 : 8;
-    int name_width = bounds.size.w / 2 - x_padding;
-    int time_width = bounds.size.w / 2 - x_padding;
-
     // Draw each prayer row
+    int16_t row_inset = s_layout.x_padding - 4;
     for (int i = 0; i < 5; i++) {
-        int y = start_y + (i * row_height);
-        PrayerIndex idx = DISPLAY_INDICES[i];
-        bool is_current = (idx == g_prayer_data.current_prayer_index);
-
-        GRect row_rect = GRect(x_padding - 4, y, bounds.size.w - (x_padding - 4) * 2, row_height);
+        int16_t y = s_layout.start_y + (i * s_layout.row_height);
+        bool is_current = (DISPLAY_INDICES[i] == g_prayer_data.current_prayer_index);
 
         // Draw highlight background for current prayer
         if (is_current && g_prayer_data.data_valid) {
+            GRect row_rect = GRect(row_inset, y, bounds.size.w - row_inset * 2, s_layout.row_height);
             graphics_context_set_fill_color(ctx, highlight_bg);
             graphics_fill_rect(ctx, row_rect, 4, GCornersAll);
             graphics_context_set_text_color(ctx, highlight_text);
@@ -79,27 +96,22 @@ static void canvas_update_proc(Layer *layer, GContext *ctx) {
         }
 
         // Draw prayer name
-        GRect name_rect = GRect(x_padding, y + 2, name_width, row_height - 4);
-        graphics_draw_text(ctx, DISPLAY_NAMES[i],
-                          fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD),
+        GRect name_rect = GRect(s_layout.x_padding, y + 2, s_layout.column_width, s_layout.row_height - 4);
+        graphics_draw_text(ctx, DISPLAY_NAMES[i], s_title_font,
                           name_rect, GTextOverflowModeTrailingEllipsis,
                           GTextAlignmentLeft, NULL);
 
         // Draw prayer time
-        char time_buf[16];
-        format_prayer_time(g_prayer_data.times[idx], time_buf, sizeof(time_buf));
-
-        GRect time_rect = GRect(bounds.size.w / 2, y + 2, time_width, row_height - 4);
-        graphics_draw_text(ctx, time_buf,
-                          fonts_get_system_font(FONT_KEY_GOTHIC_18),
+        GRect time_rect = GRect(bounds.size.w / 2, y + 2, s_layout.column_width, s_layout.row_height - 4);
+        graphics_draw_text(ctx, s_time_buffers[i], s_time_font,
                           time_rect, GTextOverflowModeTrailingEllipsis,
                           GTextAlignmentRight, NULL);
     }
 
     // Footer hint
     graphics_context_set_text_color(ctx, text_color);
-    GRect hint_rect = GRect(0, bounds.size.h - (is_round ? 24 : 18), bounds.size.w, 16);
-    graphics_draw_text(ctx, "< Back", fonts_get_system_font(FONT_KEY_GOTHIC_14),
+    GRect hint_rect = GRect(s_layout.hint_x, s_layout.hint_y, bounds.size.w - s_layout.hint_x * 2, 16);
+    graphics_draw_text(ctx, PBL_IF_ROUND_ELSE("UP Qibla  DN Month", "UP Qibla  DOWN Month"), s_hint_font,
                        hint_rect, GTextOverflowModeTrailingEllipsis,
                        GTextAlignmentCenter, NULL);
 }
@@ -109,15 +121,47 @@ static void back_click_handler(ClickRecognizerRef recognizer, void *context) {
     window_stack_pop(true);
 }
 
+// Up button handler - show the Qibla compass
+static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+    window_stack_push(prayer_qibla_get_window(), true);
+}
+
+// Down button handler - show the month view
+static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+    window_stack_push(prayer_month_get_window(), true);
+}
+
 // Click config provider
 static void click_config_provider(void *context) {
     window_single_click_subscribe(BUTTON_ID_BACK, back_click_handler);
+    window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
+    window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
 }
 
 // Window load handler
 static void window_load(Window *window) {
     Layer *window_layer = window_get_root_layer(window);
     GRect bounds = layer_get_bounds(window_layer);
+    bool is_round = PBL_IF_ROUND_ELSE(true, false);
+
+    // Layout for rect vs round displays
+    // On round the rows and hint end above the bottom of the bezel, and the
+    // hint is shortened and inset to the ~100px the display is wide there
+    s_layout = (ListLayout) {
+        .title_y = is_round ? 12 : 4,
+        .start_y = is_round ? 34 : 28,
+        .row_height = is_round ? 23 : 24,
+        .x_padding = is_round ? 25 : 8,
+        .hint_y = bounds.size.h - (is_round ? 30 : 18)
+    };
+    s_layout.column_width = bounds.size.w / 2 - s_layout.x_padding;
+    s_layout.hint_x = is_round ? s_layout.x_padding : 0;
+
+    s_title_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+    s_time_font = fonts_get_system_font(FONT_KEY_GOTHIC_18);
+    s_hint_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+
+    format_all_times();
 
     // Create canvas layer
     s_canvas_layer = layer_create(bounds);
@@ -128,6 +172,7 @@ static void window_load(Window *window) {
 // Window unload handler
 static void window_unload(Window *window) {
     layer_destroy(s_canvas_layer);
+    s_canvas_layer = NULL;
 }
 
 void prayer_list_init(void) {
@@ -151,6 +196,7 @@ Window* prayer_list_get_window(void) {
 
 void prayer_list_update(void) {
     if (s_canvas_layer) {
+        format_all_times();
         layer_mark_dirty(s_canvas_layer);
     }
 }
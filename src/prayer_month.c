@@ -0,0 +1,186 @@
+#include <pebble.h>
+#include "prayer_month.h"
+#include "prayer_data.h"
+#include "location_profiles.h"
+
+// Window and layers
+static Window *s_month_window;
+static MenuLayer *s_menu_layer;
+static Layer *s_frame_end_layer;
+
+// Fonts, looked up once per window load
+static GFont s_date_font;
+static GFont s_time_font;
+
+// Row draw cost, logged when the window closes
+// A row takes well under time_ms()'s 1ms resolution, so whole frames are
+// timed, from the first row drawn to a layer drawn after the menu
+static uint32_t s_frame_start_ms;
+static bool s_frame_open;
+static uint32_t s_draw_ms;
+static uint32_t s_rows_drawn;
+
+// Prayers shown per row (no sunrise)
+static const PrayerIndex ROW_INDICES[] = {PRAYER_FAJR, PRAYER_DHUHR, PRAYER_ASR, PRAYER_MAGHRIB, PRAYER_ISHA};
+
+// Row height for rect vs round displays
+#define ROW_HEIGHT PBL_IF_ROUND_ELSE(48, 42)
+
+// Current time in milliseconds
+static uint32_t now_ms(void) {
+    time_t seconds;
+    uint16_t millis;
+    time_ms(&seconds, &millis);
+    return (uint32_t)seconds * 1000 + millis;
+}
+
+// Format minutes since midnight without AM/PM to fit five per row
+static void format_compact_time(int16_t minutes, char* buffer, size_t size) {
+    if (minutes < 0) {
+        snprintf(buffer, size, "--");
+        return;
+    }
+
+    int hours = minutes / 60;
+    if (!clock_is_24h_style()) {
+        hours = hours % 12;
+        if (hours == 0) hours = 12;
+    }
+    snprintf(buffer, size, "%d:%02d", hours, minutes % 60);
+}
+
+// Number of schedule days from today onwards
+static uint16_t get_num_rows(MenuLayer *menu_layer, uint16_t section_index, void *context) {
+    const LocationProfile *profile = location_profiles_get(location_profiles_get_active());
+    int today = location_profiles_get_day_index(profile);
+    if (today < 0) {
+        return 1; // Placeholder row
+    }
+    return profile->num_days - today;
+}
+
+static int16_t get_cell_height(MenuLayer *menu_layer, MenuIndex *cell_index, void *context) {
+    return ROW_HEIGHT;
+}
+
+// Draw one day, decoded on demand from the packed schedule
+static void draw_row(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index, void *context) {
+    if (!s_frame_open) {
+        s_frame_open = true;
+        s_frame_start_ms = now_ms();
+    }
+    s_rows_drawn++;
+
+    GRect bounds = layer_get_bounds((Layer *)cell_layer);
+    int16_t x_padding = PBL_IF_ROUND_ELSE(16, 2);
+    int16_t width = bounds.size.w - (x_padding * 2);
+
+    const LocationProfile *profile = location_profiles_get(location_profiles_get_active());
+    int today = location_profiles_get_day_index(profile);
+    if (today < 0) {
+        graphics_draw_text(ctx, "No schedule yet", s_date_font,
+                           GRect(x_padding, 8, width, 24), GTextOverflowModeTrailingEllipsis,
+                           GTextAlignmentCenter, NULL);
+        return;
+    }
+
+    int day = today + cell_index->row;
+    if (day >= profile->num_days) return;
+    const int16_t *times = profile->schedule[day];
+
+    // Date line - use noon so DST days don't land on the wrong date
+    char date_buf[20];
+    time_t noon = time_start_of_today() + (cell_index->row * 86400) + 43200;
+    strftime(date_buf, sizeof(date_buf), cell_index->row == 0 ? "Today, %d %b" : "%a, %d %b",
+             localtime(&noon));
+    graphics_draw_text(ctx, date_buf, s_date_font,
+                       GRect(x_padding, -2, width, 20), GTextOverflowModeTrailingEllipsis,
+                       GTextAlignmentLeft, NULL);
+
+    // Five prayer times in equal columns
+    int16_t column_width = width / ARRAY_LENGTH(ROW_INDICES);
+    for (size_t i = 0; i < ARRAY_LENGTH(ROW_INDICES); i++) {
+        char time_buf[8];
+        format_compact_time(times[ROW_INDICES[i]], time_buf, sizeof(time_buf));
+        graphics_draw_text(ctx, time_buf, s_time_font,
+                           GRect(x_padding + i * column_width, 18, column_width, 18),
+                           GTextOverflowModeTrailingEllipsis, GTextAlignmentCenter, NULL);
+    }
+}
+
+// Drawn after the menu, closing the frame its rows were timed in
+static void frame_end_update_proc(Layer *layer, GContext *ctx) {
+    if (s_frame_open) {
+        s_draw_ms += now_ms() - s_frame_start_ms;
+        s_frame_open = false;
+    }
+}
+
+// Window load handler
+static void window_load(Window *window) {
+    Layer *window_layer = window_get_root_layer(window);
+    GRect bounds = layer_get_bounds(window_layer);
+
+    s_date_font = fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD);
+    s_time_font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    s_draw_ms = 0;
+    s_rows_drawn = 0;
+    s_frame_open = false;
+
+    // Only visible rows are drawn, so memory use doesn't grow with the schedule
+    s_menu_layer = menu_layer_create(bounds);
+    menu_layer_set_callbacks(s_menu_layer, NULL, (MenuLayerCallbacks) {
+        .get_num_rows = get_num_rows,
+        .get_cell_height = get_cell_height,
+        .draw_row = draw_row
+    });
+    menu_layer_set_normal_colors(s_menu_layer, GColorBlack, GColorWhite);
+    menu_layer_set_highlight_colors(s_menu_layer,
+                                    PBL_IF_COLOR_ELSE(GColorDarkGreen, GColorWhite),
+                                    PBL_IF_COLOR_ELSE(GColorWhite, GColorBlack));
+    menu_layer_set_click_config_onto_window(s_menu_layer, window);
+    layer_add_child(window_layer, menu_layer_get_layer(s_menu_layer));
+
+    // Draws nothing; only marks the end of each frame
+    s_frame_end_layer = layer_create(bounds);
+    layer_set_update_proc(s_frame_end_layer, frame_end_update_proc);
+    layer_add_child(window_layer, s_frame_end_layer);
+}
+
+// Window unload handler
+static void window_unload(Window *window) {
+    if (s_rows_drawn > 0) {
+        APP_LOG(APP_LOG_LEVEL_DEBUG, "Month view: %lu rows drawn, avg %lu us/row",
+                (unsigned long)s_rows_drawn,
+                (unsigned long)(s_draw_ms * 1000 / s_rows_drawn));
+    }
+
+    layer_destroy(s_frame_end_layer);
+    s_frame_end_layer = NULL;
+    menu_layer_destroy(s_menu_layer);
+    s_menu_layer = NULL;
+}
+
+void prayer_month_init(void) {
+    s_month_window = window_create();
+
+    window_set_background_color(s_month_window, GColorBlack);
+    window_set_window_handlers(s_month_window, (WindowHandlers) {
+        .load = window_load,
+        .unload = window_unload
+    });
+}
+
+void prayer_month_deinit(void) {
+    window_destroy(s_month_window);
+}
+
+Window* prayer_month_get_window(void) {
+    return s_month_window;
+}
+
+void prayer_month_update(void) {
+    if (s_menu_layer) {
+        menu_layer_reload_data(s_menu_layer);
+    }
+}
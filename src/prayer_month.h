@@ -0,0 +1,15 @@
+#pragma once
+
+#include <pebble.h>
+
+// Initialize the month view window
+void prayer_month_init(void);
+
+// Deinitialize the month view window
+void prayer_month_deinit(void);
+
+// Get the month view window
+Window* prayer_month_get_window(void);
+
+// Reload rows after the schedule or active profile changes
+void prayer_month_update(void);
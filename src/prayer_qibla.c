@@ -0,0 +1,207 @@
+#include <pebble.h>
+#include "prayer_qibla.h"
+#include "location_profiles.h"
+
+// Compass updates smaller than this are ignored by the service
+#define HEADING_FILTER_DEGREES 3
+
+// Needle geometry
+#define NEEDLE_INSET 8
+#define NEEDLE_TAIL_PERCENT 35
+
+// Window and layers
+static Window *s_qibla_window;
+static Layer *s_dial_layer;
+static Layer *s_needle_layer;
+static TextLayer *s_status_layer;
+
+// Compass state
+static int32_t s_qibla_angle = -1;        // Bearing to the Kaaba from true north
+static int32_t s_needle_angle = -1;       // Needle angle on screen, clockwise from 12 o'clock
+static CompassStatus s_compass_status = CompassStatusDataInvalid;
+static char s_status_buffer[32];
+
+// Point at a fixed-point angle and radius from the center
+static GPoint point_on_circle(GPoint center, int32_t angle, int32_t radius) {
+    return GPoint(
+        center.x + (int16_t)(sin_lookup(angle) * radius / TRIG_MAX_RATIO),
+        center.y - (int16_t)(cos_lookup(angle) * radius / TRIG_MAX_RATIO)
+    );
+}
+
+// Static dial - ring and a 12 o'clock marker
+static void dial_update_proc(Layer *layer, GContext *ctx) {
+    GRect bounds = layer_get_bounds(layer);
+    GPoint center = grect_center_point(&bounds);
+    int16_t radius = (bounds.size.w < bounds.size.h ? bounds.size.w : bounds.size.h) / 2 - 2;
+
+    graphics_context_set_stroke_color(ctx, PBL_IF_COLOR_ELSE(GColorDarkGray, GColorWhite));
+    graphics_draw_circle(ctx, center, radius);
+
+    graphics_context_set_stroke_color(ctx, GColorWhite);
+    graphics_draw_line(ctx, GPoint(center.x, center.y - radius),
+                       GPoint(center.x, center.y - radius + 6));
+}
+
+// Needle - the only part redrawn as the heading changes
+static void needle_update_proc(Layer *layer, GContext *ctx) {
+    if (s_needle_angle < 0 || s_compass_status == CompassStatusDataInvalid) {
+        return;
+    }
+
+    GRect bounds = layer_get_bounds(layer);
+    GPoint center = grect_center_point(&bounds);
+    int32_t length = bounds.size.w / 2 - NEEDLE_INSET;
+
+    GPoint tip = point_on_circle(center, s_needle_angle, length);
+    GPoint tail = point_on_circle(center, s_needle_angle + TRIG_MAX_ANGLE / 2,
+                                  length * NEEDLE_TAIL_PERCENT / 100);
+
+    // Dim the needle until the compass is calibrated
+    // Black and white has no grey, so there it is thin with a hollow tip instead
+    bool calibrated = (s_compass_status == CompassStatusCalibrated);
+    GColor needle_color = calibrated ? PBL_IF_COLOR_ELSE(GColorMediumSpringGreen, GColorWhite)
+                                     : PBL_IF_COLOR_ELSE(GColorLightGray, GColorWhite);
+    bool hollow_tip = PBL_IF_COLOR_ELSE(false, !calibrated);
+
+    // The tail is thin on black and white, where it can't be dimmed
+    graphics_context_set_stroke_width(ctx, PBL_IF_COLOR_ELSE(3, 1));
+    graphics_context_set_stroke_color(ctx, PBL_IF_COLOR_ELSE(GColorDarkGray, GColorWhite));
+    graphics_draw_line(ctx, center, tail);
+    graphics_context_set_stroke_width(ctx, hollow_tip ? 1 : 3);
+    graphics_context_set_stroke_color(ctx, needle_color);
+    graphics_draw_line(ctx, center, tip);
+
+    graphics_context_set_fill_color(ctx, needle_color);
+    if (hollow_tip) {
+        graphics_draw_circle(ctx, tip, 4);
+    } else {
+        graphics_fill_circle(ctx, tip, 4);
+    }
+    graphics_fill_circle(ctx, center, 3);
+}
+
+// Update the status line only when the compass state changes
+static void update_status(CompassStatus status) {
+    if (status == s_compass_status && s_status_buffer[0] != '\0') {
+        return;
+    }
+    s_compass_status = status;
+
+    if (s_qibla_angle < 0) {
+        snprintf(s_status_buffer, sizeof(s_status_buffer), "No location yet");
+    } else if (status == CompassStatusDataInvalid) {
+        snprintf(s_status_buffer, sizeof(s_status_buffer), "Compass unavailable");
+    } else if (status == CompassStatusCalibrating) {
+        snprintf(s_status_buffer, sizeof(s_status_buffer), "Rotate wrist to calibrate");
+    } else {
+        snprintf(s_status_buffer, sizeof(s_status_buffer), "Qibla %d°",
+                 (int)TRIGANGLE_TO_DEG(s_qibla_angle));
+    }
+    text_layer_set_text(s_status_layer, s_status_buffer);
+
+    // Needle visibility and color depend on the status
+    layer_mark_dirty(s_needle_layer);
+}
+
+// Compass heading handler (already throttled by the heading filter)
+static void compass_heading_handler(CompassHeadingData heading_data) {
+    update_status(heading_data.compass_status);
+
+    if (s_qibla_angle < 0 || heading_data.compass_status == CompassStatusDataInvalid) {
+        return;
+    }
+
+    // Headings increase counter-clockwise, so adding them turns the
+    // true bearing into an angle relative to the top of the watch
+    CompassHeading heading = heading_data.is_declination_valid ?
+                             heading_data.true_heading : heading_data.magnetic_heading;
+    int32_t needle_angle = (s_qibla_angle + heading) % TRIG_MAX_ANGLE;
+
+    if (needle_angle != s_needle_angle) {
+        s_needle_angle = needle_angle;
+        layer_mark_dirty(s_needle_layer);
+    }
+}
+
+// Window load handler
+static void window_load(Window *window) {
+    Layer *window_layer = window_get_root_layer(window);
+    GRect bounds = layer_get_bounds(window_layer);
+    bool is_round = PBL_IF_ROUND_ELSE(true, false);
+
+    // Square compass area above the status line
+    int16_t status_height = 24;
+    int16_t size = bounds.size.h - status_height - (is_round ? 24 : 8);
+    if (size > bounds.size.w - 8) size = bounds.size.w - 8;
+    GRect dial_rect = GRect((bounds.size.w - size) / 2, is_round ? 16 : 4, size, size);
+
+    s_dial_layer = layer_create(dial_rect);
+    layer_set_update_proc(s_dial_layer, dial_update_proc);
+    layer_add_child(window_layer, s_dial_layer);
+
+    // Needle gets its own layer so heading changes don't touch the dial
+    s_needle_layer = layer_create(dial_rect);
+    layer_set_update_proc(s_needle_layer, needle_update_proc);
+    layer_add_child(window_layer, s_needle_layer);
+
+    s_status_layer = text_layer_create(GRect(0, dial_rect.origin.y + size + 2,
+                                             bounds.size.w, status_height));
+    text_layer_set_background_color(s_status_layer, GColorClear);
+    text_layer_set_text_color(s_status_layer, GColorWhite);
+    text_layer_set_font(s_status_layer, fonts_get_system_font(FONT_KEY_GOTHIC_18_BOLD));
+    text_layer_set_text_alignment(s_status_layer, GTextAlignmentCenter);
+    layer_add_child(window_layer, text_layer_get_layer(s_status_layer));
+}
+
+// Window appear handler - sample the compass only while visible
+static void window_appear(Window *window) {
+    const LocationProfile *profile = location_profiles_get(location_profiles_get_active());
+    s_qibla_angle = (profile->num_days > 0) ? profile->qibla_angle : -1;
+    s_needle_angle = -1;
+    s_status_buffer[0] = '\0';
+
+    // Platforms without a compass leave the data untouched
+    CompassHeadingData heading_data = { .compass_status = CompassStatusDataInvalid };
+    if (compass_service_peek(&heading_data) != 0) {
+        heading_data.compass_status = CompassStatusDataInvalid;
+    }
+    compass_heading_handler(heading_data);
+
+    if (s_qibla_angle >= 0) {
+        compass_service_set_heading_filter(DEG_TO_TRIGANGLE(HEADING_FILTER_DEGREES));
+        compass_service_subscribe(compass_heading_handler);
+    }
+}
+
+// Window disappear handler
+static void window_disappear(Window *window) {
+    compass_service_unsubscribe();
+}
+
+// Window unload handler
+static void window_unload(Window *window) {
+    text_layer_destroy(s_status_layer);
+    layer_destroy(s_needle_layer);
+    layer_destroy(s_dial_layer);
+}
+
+void prayer_qibla_init(void) {
+    s_qibla_window = window_create();
+
+    window_set_background_color(s_qibla_window, GColorBlack);
+    window_set_window_handlers(s_qibla_window, (WindowHandlers) {
+        .load = window_load,
+        .appear = window_appear,
+        .disappear = window_disappear,
+        .unload = window_unload
+    });
+}
+
+void prayer_qibla_deinit(void) {
+    window_destroy(s_qibla_window);
+}
+
+Window* prayer_qibla_get_window(void) {
+    return s_qibla_window;
+}
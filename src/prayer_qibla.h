@@ -0,0 +1,12 @@
+#pragma once
+
+#include <pebble.h>
+
+// Initialize the Qibla compass window
+void prayer_qibla_init(void);
+
+// Deinitialize the Qibla compass window
+void prayer_qibla_deinit(void);
+
+// Get the Qibla compass window
+Window* prayer_qibla_get_window(void);
@@ -0,0 +1,28 @@
+#pragma once
+
+// AppMessage keys as the phone sends them, for the test drivers that play
+// the phone side (same order as messageKeys in package.json)
+
+enum {
+    KEY_REQUEST_DATA = 0,
+    KEY_FAJR_TIME,
+    KEY_SUNRISE_TIME,
+    KEY_DHUHR_TIME,
+    KEY_ASR_TIME,
+    KEY_MAGHRIB_TIME,
+    KEY_ISHA_TIME,
+    KEY_NEXT_PRAYER_NAME,
+    KEY_NEXT_PRAYER_TIME,
+    KEY_COUNTDOWN_SECONDS,
+    KEY_LOCATION_NAME,
+    KEY_ERROR_CODE,
+    KEY_ERROR_MESSAGE,
+    KEY_NEXT_PRAYER_INDEX,
+    KEY_PROFILE_INDEX,
+    KEY_PROFILE_NAME,
+    KEY_PROFILE_START,
+    KEY_PROFILE_SCHEDULE,
+    KEY_ACTIVE_PROFILE,
+    KEY_PROFILE_MASK,
+    KEY_QIBLA_ANGLE
+};
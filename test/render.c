@@ -0,0 +1,482 @@
+// Headless rendering harness
+// Runs the real app on one platform's screen against a software
+// framebuffer, renders the main window and the prayer list in each state,
+// and compares every frame with its golden PNG in golden/<platform>/.
+// Prints the draw calls and text draws of each frame, fails a frame that
+// goes over its draw budget, and checks the prayer list layout.
+
+#include <errno.h>
+#include <getopt.h>
+#include <zlib.h>
+#include "fake_pebble.h"
+#include "message_keys.h"
+
+// Entry point of the app (main.c is built with main renamed)
+int pebble_app_main(void);
+
+// Fixed wall clock, so countdowns render the same on every run
+#define RENDER_START "2026-03-20 07:30:00"
+
+// Phone response delay
+#define PHONE_FETCH_DELAY_MS 300
+
+#define MAX_FRAME_CALLS 64
+
+static struct {
+    const char *golden_dir;
+    const char *out_dir;
+    bool update;
+} s_options = {
+    .golden_dir = "golden/" SIM_PLATFORM_NAME,
+    .out_dir = "build/" SIM_PLATFORM_NAME
+};
+
+static int s_failures;
+
+// Phone
+
+static void phone_send_prayer_data(void *data) {
+    static const int16_t TIMES[] = { 310, 388, 750, 952, 1113, 1190 };
+
+    DictionaryIterator message;
+    sim_dict_init(&message);
+    for (size_t i = 0; i < ARRAY_LENGTH(TIMES); i++) {
+        dict_write_int32(&message, KEY_FAJR_TIME + i, TIMES[i]);
+    }
+    dict_write_cstring(&message, KEY_NEXT_PRAYER_NAME, "Dhuhr");
+    dict_write_cstring(&message, KEY_NEXT_PRAYER_TIME, "12:30 PM");
+    dict_write_int32(&message, KEY_COUNTDOWN_SECONDS, 5 * 3600);
+    dict_write_cstring(&message, KEY_LOCATION_NAME, "Makkah");
+    dict_write_int32(&message, KEY_ERROR_CODE, 0);
+    sim_phone_send(&message, 0);
+}
+
+static void phone_send_error(void *data) {
+    DictionaryIterator message;
+    sim_dict_init(&message);
+    dict_write_int32(&message, KEY_ERROR_CODE, 1);
+    dict_write_cstring(&message, KEY_ERROR_MESSAGE, "Location unavailable");
+    sim_phone_send(&message, 0);
+}
+
+static void phone_receive(const DictionaryIterator *message) {
+    if (dict_find(message, KEY_REQUEST_DATA)) {
+        sim_schedule(sim_now_ms() + PHONE_FETCH_DELAY_MS, phone_send_prayer_data, NULL);
+    }
+}
+
+// Frames
+
+typedef struct {
+    const char *name;
+    bool is_list;
+    uint32_t max_draw_calls;
+    uint32_t max_text_draws;
+} Frame;
+
+static SimDrawCall s_calls[MAX_FRAME_CALLS];
+static size_t s_call_count;
+
+static void record_call(const SimDrawCall *call) {
+    if (s_call_count < MAX_FRAME_CALLS) {
+        s_calls[s_call_count++] = *call;
+    }
+}
+
+static void fail(const Frame *frame, const char *message) {
+    printf("FAIL %s/%s: %s\n", SIM_PLATFORM_NAME, frame->name, message);
+    s_failures++;
+}
+
+// Golden images
+// Plain 8-bit RGB PNGs, so review tools can show them and their diffs.
+// Only PNGs written here are read back (no filters, no interlacing).
+
+#define PNG_ROW_BYTES (1 + SIM_SCREEN_WIDTH * 3)
+#define PNG_DATA_BYTES (SIM_SCREEN_HEIGHT * PNG_ROW_BYTES)
+
+static const uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+static void color_to_rgb(GColor color, uint8_t rgb[3]) {
+    rgb[0] = color.r * 85;
+    rgb[1] = color.g * 85;
+    rgb[2] = color.b * 85;
+}
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 8) | in[3];
+}
+
+static void write_chunk(FILE *file, const char *type, const uint8_t *data, uint32_t length) {
+    uint8_t header[8];
+    put_u32(header, length);
+    memcpy(header + 4, type, 4);
+    fwrite(header, 1, 8, file);
+
+    // The CRC covers the type and the data
+    uLong crc_value = crc32(0, header + 4, 4);
+    if (length > 0) {
+        fwrite(data, 1, length, file);
+        crc_value = crc32(crc_value, data, length);
+    }
+    uint8_t crc[4];
+    put_u32(crc, crc_value);
+    fwrite(crc, 1, 4, file);
+}
+
+static bool write_png(const char *path, const uint8_t *rgb) {
+    static uint8_t raw[PNG_DATA_BYTES];
+    static uint8_t compressed[PNG_DATA_BYTES + PNG_DATA_BYTES / 100 + 64];
+
+    for (int y = 0; y < SIM_SCREEN_HEIGHT; y++) {
+        raw[y * PNG_ROW_BYTES] = 0;
+        memcpy(&raw[y * PNG_ROW_BYTES + 1], &rgb[y * SIM_SCREEN_WIDTH * 3], SIM_SCREEN_WIDTH * 3);
+    }
+    uLongf compressed_length = sizeof(compressed);
+    if (compress2(compressed, &compressed_length, raw, sizeof(raw), Z_BEST_COMPRESSION) != Z_OK) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (!file) {
+        printf("Can't write %s: %s\n", path, strerror(errno));
+        return false;
+    }
+
+    uint8_t header[13] = { 0 };
+    put_u32(header, SIM_SCREEN_WIDTH);
+    put_u32(header + 4, SIM_SCREEN_HEIGHT);
+    header[8] = 8;  // Bit depth
+    header[9] = 2;  // Truecolor
+
+    fwrite(PNG_SIGNATURE, 1, sizeof(PNG_SIGNATURE), file);
+    write_chunk(file, "IHDR", header, sizeof(header));
+    write_chunk(file, "IDAT", compressed, compressed_length);
+    write_chunk(file, "IEND", NULL, 0);
+    fclose(file);
+    return true;
+}
+
+static bool read_png(const char *path, uint8_t *rgb) {
+    static uint8_t compressed[PNG_DATA_BYTES + PNG_DATA_BYTES / 100 + 64];
+    static uint8_t raw[PNG_DATA_BYTES];
+    uLongf compressed_length = 0;
+
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+
+    uint8_t signature[8];
+    bool ok = fread(signature, 1, 8, file) == 8 && memcmp(signature, PNG_SIGNATURE, 8) == 0;
+    bool header_ok = false;
+
+    uint8_t chunk[8];
+    while (ok && fread(chunk, 1, 8, file) == 8) {
+        uint32_t length = get_u32(chunk);
+        if (memcmp(chunk + 4, "IHDR", 4) == 0) {
+            uint8_t header[13];
+            ok = length == sizeof(header) && fread(header, 1, length, file) == length;
+            header_ok = ok && get_u32(header) == SIM_SCREEN_WIDTH &&
+                        get_u32(header + 4) == SIM_SCREEN_HEIGHT &&
+                        header[8] == 8 && header[9] == 2 && header[12] == 0;
+        } else if (memcmp(chunk + 4, "IDAT", 4) == 0) {
+            ok = compressed_length + length <= sizeof(compressed) &&
+                 fread(compressed + compressed_length, 1, length, file) == length;
+            compressed_length += length;
+        } else {
+            ok = fseek(file, length, SEEK_CUR) == 0;
+        }
+        ok = ok && fseek(file, 4, SEEK_CUR) == 0;  // CRC
+    }
+    fclose(file);
+
+    uLongf raw_length = sizeof(raw);
+    if (!ok || !header_ok ||
+        uncompress(raw, &raw_length, compressed, compressed_length) != Z_OK ||
+        raw_length != sizeof(raw)) {
+        return false;
+    }
+
+    for (int y = 0; y < SIM_SCREEN_HEIGHT; y++) {
+        if (raw[y * PNG_ROW_BYTES] != 0) return false;
+        memcpy(&rgb[y * SIM_SCREEN_WIDTH * 3], &raw[y * PNG_ROW_BYTES + 1], SIM_SCREEN_WIDTH * 3);
+    }
+    return true;
+}
+
+// Compare a frame with its golden image, writing the frame and a diff on mismatch
+// (differing pixels in red over the dimmed frame)
+static void compare_golden(const Frame *frame, const GColor *pixels) {
+    static uint8_t actual[SIM_FRAMEBUFFER_PIXELS * 3];
+    static uint8_t golden[SIM_FRAMEBUFFER_PIXELS * 3];
+    char path[256];
+
+    for (int i = 0; i < SIM_FRAMEBUFFER_PIXELS; i++) {
+        color_to_rgb(pixels[i], &actual[i * 3]);
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.png", s_options.golden_dir, frame->name);
+    if (s_options.update) {
+        if (!write_png(path, actual)) s_failures++;
+        return;
+    }
+
+    if (!read_png(path, golden)) {
+        fail(frame, "missing golden image (run make update-golden)");
+        snprintf(path, sizeof(path), "%s/%s.png", s_options.out_dir, frame->name);
+        write_png(path, actual);
+        return;
+    }
+
+    int mismatched = 0;
+    for (int i = 0; i < SIM_FRAMEBUFFER_PIXELS; i++) {
+        if (memcmp(&actual[i * 3], &golden[i * 3], 3) != 0) {
+            mismatched++;
+            golden[i * 3] = 255;
+            golden[i * 3 + 1] = 0;
+            golden[i * 3 + 2] = 0;
+        } else {
+            for (int c = 0; c < 3; c++) {
+                golden[i * 3 + c] = actual[i * 3 + c] / 3;
+            }
+        }
+    }
+
+    snprintf(path, sizeof(path), "%s/%s.png", s_options.out_dir, frame->name);
+    char diff_path[256];
+    snprintf(diff_path, sizeof(diff_path), "%s/%s-diff.png", s_options.out_dir, frame->name);
+    if (mismatched == 0) {
+        // Clear output left by an earlier failing run
+        remove(path);
+        remove(diff_path);
+        return;
+    }
+
+    char message[512];
+    snprintf(message, sizeof(message), "%d pixels differ from the golden image (see %s)",
+             mismatched, diff_path);
+    fail(frame, message);
+
+    write_png(path, actual);
+    write_png(diff_path, golden);
+}
+
+// Layout checks
+
+static bool inside_screen_rows(GRect box) {
+    return box.origin.y >= 0 && box.origin.y + box.size.h <= SIM_SCREEN_HEIGHT;
+}
+
+// The list draws a title, a name and a time per prayer, and a hint, over the
+// window's own background: at most one fill, for the current prayer's row
+static void check_list_layout(const Frame *frame) {
+    const SimDrawCall *texts[12];
+    const SimDrawCall *fill = NULL;
+    size_t text_count = 0, fill_count = 0;
+
+    for (size_t i = 0; i < s_call_count; i++) {
+        if (s_calls[i].kind == SIM_DRAW_TEXT) {
+            if (text_count < ARRAY_LENGTH(texts)) texts[text_count] = &s_calls[i];
+            text_count++;
+        } else if (s_calls[i].kind == SIM_FILL_RECT) {
+            fill = &s_calls[i];
+            fill_count++;
+        }
+    }
+    if (text_count != ARRAY_LENGTH(texts)) {
+        fail(frame, "expected a title, 5 names, 5 times and a hint");
+        return;
+    }
+    if (fill_count > 1) {
+        fail(frame, "more than one fill (the window already paints the background)");
+    }
+
+    GRect title = texts[0]->rect;
+    GRect hint = texts[11]->rect;
+    int16_t row_height = texts[3]->rect.origin.y - texts[1]->rect.origin.y;
+    int16_t x_padding = texts[1]->rect.origin.x;
+    bool fill_matches_row = false;
+
+    for (int i = 0; i < 5; i++) {
+        GRect name = texts[1 + i * 2]->rect;
+        GRect time = texts[2 + i * 2]->rect;
+        int16_t row_y = name.origin.y - 2;
+
+        if (i > 0 && name.origin.y - texts[i * 2 - 1]->rect.origin.y != row_height) {
+            fail(frame, "rows are not evenly spaced");
+        }
+        if (name.size.h != row_height - 4 || time.origin.y != name.origin.y) {
+            fail(frame, "row text is not inset 2px in its row");
+        }
+        if (name.origin.x != x_padding || time.origin.x + time.size.w != SIM_SCREEN_WIDTH - x_padding) {
+            fail(frame, "name and time columns are not padded evenly");
+        }
+        if (fill && fill->rect.origin.y == row_y && fill->rect.size.h == row_height &&
+            fill->rect.origin.x == x_padding - 4 &&
+            fill->rect.size.w == SIM_SCREEN_WIDTH - (x_padding - 4) * 2) {
+            fill_matches_row = true;
+        }
+    }
+
+    if (fill && !fill_matches_row) {
+        fail(frame, "fill is not a row highlight");
+    }
+    if (title.origin.y + title.size.h > texts[1]->rect.origin.y - 2) {
+        fail(frame, "title overlaps the first row");
+    }
+    if (texts[9]->rect.origin.y - 2 + row_height > hint.origin.y) {
+        fail(frame, "last row overlaps the hint");
+    }
+    for (size_t i = 0; i < text_count; i++) {
+        if (!inside_screen_rows(texts[i]->rect)) {
+            fail(frame, "text box runs off the screen");
+            break;
+        }
+    }
+}
+
+static void check_display_layout(const Frame *frame) {
+    for (size_t i = 0; i < s_call_count; i++) {
+        if (!inside_screen_rows(s_calls[i].rect)) {
+            fail(frame, "text layer runs off the screen");
+            break;
+        }
+    }
+}
+
+static void capture(void *data) {
+    const Frame *frame = data;
+    static GColor pixels[SIM_FRAMEBUFFER_PIXELS];
+
+    uint32_t draw_calls = g_sim_counters.draw_calls;
+    uint32_t text_draws = g_sim_counters.text_draws;
+    s_call_count = 0;
+
+    GContext ctx;
+    sim_graphics_context_init(&ctx);
+    sim_framebuffer_attach(pixels);
+    sim_set_draw_observer(record_call);
+    sim_render_window(&ctx);
+    sim_set_draw_observer(NULL);
+    sim_framebuffer_attach(NULL);
+
+    draw_calls = g_sim_counters.draw_calls - draw_calls;
+    text_draws = g_sim_counters.text_draws - text_draws;
+    printf("%-8s %-16s %10u %10u\n", SIM_PLATFORM_NAME, frame->name, draw_calls, text_draws);
+
+    if (draw_calls > frame->max_draw_calls || text_draws > frame->max_text_draws) {
+        char message[128];
+        snprintf(message, sizeof(message), "over its budget of %u draw calls and %u text draws",
+                 frame->max_draw_calls, frame->max_text_draws);
+        fail(frame, message);
+    }
+    if (frame->is_list) {
+        check_list_layout(frame);
+    } else {
+        check_display_layout(frame);
+    }
+    compare_golden(frame, pixels);
+}
+
+// Script
+
+static const Frame FRAME_DISPLAY_LOADING = { "display-loading", false, 1, 1 };
+static const Frame FRAME_DISPLAY_VALID = { "display-valid", false, 6, 6 };
+static const Frame FRAME_LIST_VALID = { "list-valid", true, 13, 12 };
+static const Frame FRAME_DISPLAY_ERROR = { "display-error", false, 3, 3 };
+static const Frame FRAME_LIST_NO_DATA = { "list-no-data", true, 12, 12 };
+
+static void press_down(void *data) {
+    sim_click(BUTTON_ID_DOWN);
+}
+
+static void press_back(void *data) {
+    sim_click(BUTTON_ID_BACK);
+}
+
+typedef struct {
+    uint32_t at_ms;     // After launch
+    SimEventCallback callback;
+    const void *data;
+} Step;
+
+static const Step SCRIPT[] = {
+    { 200, capture, &FRAME_DISPLAY_LOADING },
+    { 2000, capture, &FRAME_DISPLAY_VALID },
+    { 3000, press_down, NULL },
+    { 3500, capture, &FRAME_LIST_VALID },
+    { 4000, press_back, NULL },
+    { 5000, phone_send_error, NULL },
+    { 6000, capture, &FRAME_DISPLAY_ERROR },
+    { 7000, press_down, NULL },
+    { 7500, capture, &FRAME_LIST_NO_DATA },
+};
+
+// Options
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --golden DIR   golden images (default %s)\n"
+            "  --out DIR      where to write failing frames and diffs (default %s)\n"
+            "  --update       write the frames as the new golden images\n",
+            name, s_options.golden_dir, s_options.out_dir);
+}
+
+static bool parse_options(int argc, char **argv) {
+    enum { OPT_GOLDEN = 1, OPT_OUT, OPT_UPDATE };
+    static const struct option long_options[] = {
+        { "golden", required_argument, NULL, OPT_GOLDEN },
+        { "out", required_argument, NULL, OPT_OUT },
+        { "update", no_argument, NULL, OPT_UPDATE },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (option) {
+            case OPT_GOLDEN: s_options.golden_dir = optarg; break;
+            case OPT_OUT: s_options.out_dir = optarg; break;
+            case OPT_UPDATE: s_options.update = true; break;
+            default: return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_options(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    struct tm start = { 0 };
+    strptime(RENDER_START, "%Y-%m-%d %H:%M:%S", &start);
+    time_t start_time = timegm(&start);
+    int64_t start_ms = (int64_t)start_time * 1000;
+
+    sim_set_time(start_time);
+    sim_set_phone_handler(phone_receive);
+    for (size_t i = 0; i < ARRAY_LENGTH(SCRIPT); i++) {
+        sim_schedule(start_ms + SCRIPT[i].at_ms, SCRIPT[i].callback, (void *)SCRIPT[i].data);
+    }
+    sim_set_run_until(start_time + 8);
+
+    pebble_app_main();
+
+    if (s_failures > 0) {
+        printf("FAIL: %d check(s) failed on %s\n", s_failures, SIM_PLATFORM_NAME);
+        return 1;
+    }
+    return 0;
+}
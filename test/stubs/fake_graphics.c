@@ -0,0 +1,430 @@
+#define SIM_INTERNAL
+#include "fake_pebble.h"
+
+// System fonts by line height
+static const SimFont s_fonts[] = {
+    { FONT_KEY_GOTHIC_14, 14, false },
+    { FONT_KEY_GOTHIC_14_BOLD, 14, true },
+    { FONT_KEY_GOTHIC_18, 18, false },
+    { FONT_KEY_GOTHIC_18_BOLD, 18, true },
+    { FONT_KEY_GOTHIC_24, 24, false },
+    { FONT_KEY_GOTHIC_24_BOLD, 24, true },
+    { FONT_KEY_GOTHIC_28_BOLD, 28, true },
+    { FONT_KEY_BITHAM_30_BLACK, 30, true },
+    { FONT_KEY_BITHAM_42_BOLD, 42, true },
+};
+
+GFont fonts_get_system_font(const char *font_key) {
+    for (size_t i = 0; i < ARRAY_LENGTH(s_fonts); i++) {
+        if (strcmp(s_fonts[i].key, font_key) == 0) {
+            return &s_fonts[i];
+        }
+    }
+    return &s_fonts[0];
+}
+
+// 5x7 glyphs for ASCII 0x20-0x7E, one byte per column, bit 0 at the top
+static const uint8_t GLYPHS[][5] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, {0x00, 0x00, 0x5F, 0x00, 0x00}, {0x00, 0x07, 0x00, 0x07, 0x00},
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, {0x24, 0x2A, 0x7F, 0x2A, 0x12}, {0x23, 0x13, 0x08, 0x64, 0x62},
+    {0x36, 0x49, 0x55, 0x22, 0x50}, {0x00, 0x05, 0x03, 0x00, 0x00}, {0x00, 0x1C, 0x22, 0x41, 0x00},
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, {0x08, 0x2A, 0x1C, 0x2A, 0x08}, {0x08, 0x08, 0x3E, 0x08, 0x08},
+    {0x00, 0x50, 0x30, 0x00, 0x00}, {0x08, 0x08, 0x08, 0x08, 0x08}, {0x00, 0x60, 0x60, 0x00, 0x00},
+    {0x20, 0x10, 0x08, 0x04, 0x02}, {0x3E, 0x51, 0x49, 0x45, 0x3E}, {0x00, 0x42, 0x7F, 0x40, 0x00},
+    {0x42, 0x61, 0x51, 0x49, 0x46}, {0x21, 0x41, 0x45, 0x4B, 0x31}, {0x18, 0x14, 0x12, 0x7F, 0x10},
+    {0x27, 0x45, 0x45, 0x45, 0x39}, {0x3C, 0x4A, 0x49, 0x49, 0x30}, {0x01, 0x71, 0x09, 0x05, 0x03},
+    {0x36, 0x49, 0x49, 0x49, 0x36}, {0x06, 0x49, 0x49, 0x29, 0x1E}, {0x00, 0x36, 0x36, 0x00, 0x00},
+    {0x00, 0x56, 0x36, 0x00, 0x00}, {0x08, 0x14, 0x22, 0x41, 0x00}, {0x14, 0x14, 0x14, 0x14, 0x14},
+    {0x00, 0x41, 0x22, 0x14, 0x08}, {0x02, 0x01, 0x51, 0x09, 0x06}, {0x32, 0x49, 0x79, 0x41, 0x3E},
+    {0x7E, 0x11, 0x11, 0x11, 0x7E}, {0x7F, 0x49, 0x49, 0x49, 0x36}, {0x3E, 0x41, 0x41, 0x41, 0x22},
+    {0x7F, 0x41, 0x41, 0x22, 0x1C}, {0x7F, 0x49, 0x49, 0x49, 0x41}, {0x7F, 0x09, 0x09, 0x01, 0x01},
+    {0x3E, 0x41, 0x41, 0x51, 0x32}, {0x7F, 0x08, 0x08, 0x08, 0x7F}, {0x00, 0x41, 0x7F, 0x41, 0x00},
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, {0x7F, 0x08, 0x14, 0x22, 0x41}, {0x7F, 0x40, 0x40, 0x40, 0x40},
+    {0x7F, 0x02, 0x04, 0x02, 0x7F}, {0x7F, 0x04, 0x08, 0x10, 0x7F}, {0x3E, 0x41, 0x41, 0x41, 0x3E},
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, {0x3E, 0x41, 0x51, 0x21, 0x5E}, {0x7F, 0x09, 0x19, 0x29, 0x46},
+    {0x46, 0x49, 0x49, 0x49, 0x31}, {0x01, 0x01, 0x7F, 0x01, 0x01}, {0x3F, 0x40, 0x40, 0x40, 0x3F},
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, {0x7F, 0x20, 0x18, 0x20, 0x7F}, {0x63, 0x14, 0x08, 0x14, 0x63},
+    {0x03, 0x04, 0x78, 0x04, 0x03}, {0x61, 0x51, 0x49, 0x45, 0x43}, {0x00, 0x00, 0x7F, 0x41, 0x41},
+    {0x02, 0x04, 0x08, 0x10, 0x20}, {0x41, 0x41, 0x7F, 0x00, 0x00}, {0x04, 0x02, 0x01, 0x02, 0x04},
+    {0x40, 0x40, 0x40, 0x40, 0x40}, {0x00, 0x01, 0x02, 0x04, 0x00}, {0x20, 0x54, 0x54, 0x54, 0x78},
+    {0x7F, 0x48, 0x44, 0x44, 0x38}, {0x38, 0x44, 0x44, 0x44, 0x20}, {0x38, 0x44, 0x44, 0x48, 0x7F},
+    {0x38, 0x54, 0x54, 0x54, 0x18}, {0x08, 0x7E, 0x09, 0x01, 0x02}, {0x08, 0x14, 0x54, 0x54, 0x3C},
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, {0x00, 0x44, 0x7D, 0x40, 0x00}, {0x20, 0x40, 0x44, 0x3D, 0x00},
+    {0x00, 0x7F, 0x10, 0x28, 0x44}, {0x00, 0x41, 0x7F, 0x40, 0x00}, {0x7C, 0x04, 0x18, 0x04, 0x78},
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, {0x38, 0x44, 0x44, 0x44, 0x38}, {0x7C, 0x14, 0x14, 0x14, 0x08},
+    {0x08, 0x14, 0x14, 0x18, 0x7C}, {0x7C, 0x08, 0x04, 0x04, 0x08}, {0x48, 0x54, 0x54, 0x54, 0x20},
+    {0x04, 0x3F, 0x44, 0x40, 0x20}, {0x3C, 0x40, 0x40, 0x20, 0x7C}, {0x1C, 0x20, 0x40, 0x20, 0x1C},
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, {0x44, 0x28, 0x10, 0x28, 0x44}, {0x0C, 0x50, 0x50, 0x50, 0x3C},
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, {0x00, 0x08, 0x36, 0x41, 0x00}, {0x00, 0x00, 0x7F, 0x00, 0x00},
+    {0x00, 0x41, 0x36, 0x08, 0x00}, {0x02, 0x01, 0x02, 0x04, 0x02},
+};
+
+#define GLYPH_COLUMNS 5
+#define GLYPH_ROWS 7
+
+// Context state
+
+static GColor *s_framebuffer;
+static void (*s_draw_observer)(const SimDrawCall *call);
+
+void sim_framebuffer_attach(GColor *pixels) {
+    s_framebuffer = pixels;
+}
+
+void sim_set_draw_observer(void (*observer)(const SimDrawCall *call)) {
+    s_draw_observer = observer;
+}
+
+void sim_graphics_context_init(GContext *ctx) {
+    memset(ctx, 0, sizeof(GContext));
+    ctx->stroke_color = GColorBlack;
+    ctx->fill_color = GColorBlack;
+    ctx->text_color = GColorBlack;
+    ctx->stroke_width = 1;
+}
+
+void sim_graphics_set_layer(GContext *ctx, GRect screen_frame, GRect clip) {
+    ctx->offset = screen_frame.origin;
+    ctx->clip = clip;
+}
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color) {
+    ctx->stroke_color = color;
+}
+
+void graphics_context_set_fill_color(GContext *ctx, GColor color) {
+    ctx->fill_color = color;
+}
+
+void graphics_context_set_text_color(GContext *ctx, GColor color) {
+    ctx->text_color = color;
+}
+
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width) {
+    ctx->stroke_width = stroke_width;
+}
+
+// Counting
+
+static void count_draw(GContext *ctx, SimDrawKind kind, GRect rect, GColor color) {
+    g_sim_counters.draw_calls++;
+    if (s_draw_observer) {
+        SimDrawCall call = {
+            .kind = kind,
+            .rect = GRect(rect.origin.x + ctx->offset.x, rect.origin.y + ctx->offset.y,
+                          rect.size.w, rect.size.h),
+            .color = color
+        };
+        s_draw_observer(&call);
+    }
+}
+
+// Pixels
+
+// Black-and-white displays show each color as black or white by brightness
+static GColor display_color(GColor color) {
+#if defined(PBL_COLOR)
+    return color;
+#else
+    return (color.r + color.g + color.b >= 5) ? GColorWhite : GColorBlack;
+#endif
+}
+
+// Set a pixel in layer coordinates, clipped to the layer
+static void put_pixel(GContext *ctx, int x, int y, GColor color) {
+    if (color.a == 0) return;
+
+    x += ctx->offset.x;
+    y += ctx->offset.y;
+    if (x < ctx->clip.origin.x || x >= ctx->clip.origin.x + ctx->clip.size.w ||
+        y < ctx->clip.origin.y || y >= ctx->clip.origin.y + ctx->clip.size.h) {
+        return;
+    }
+    s_framebuffer[y * SIM_SCREEN_WIDTH + x] = display_color(color);
+}
+
+static void fill_span(GContext *ctx, int x0, int x1, int y, GColor color) {
+    for (int x = x0; x <= x1; x++) {
+        put_pixel(ctx, x, y, color);
+    }
+}
+
+// A dot of the stroke width centered on a point
+static void stroke_dot(GContext *ctx, int cx, int cy) {
+    int width = ctx->stroke_width > 0 ? ctx->stroke_width : 1;
+    if (width == 1) {
+        put_pixel(ctx, cx, cy, ctx->stroke_color);
+        return;
+    }
+
+    int radius = width / 2;
+    for (int dy = -radius; dy <= radius; dy++) {
+        for (int dx = -radius; dx <= radius; dx++) {
+            if (dx * dx + dy * dy <= radius * radius) {
+                put_pixel(ctx, cx + dx, cy + dy, ctx->stroke_color);
+            }
+        }
+    }
+}
+
+static void stroke_line(GContext *ctx, GPoint p0, GPoint p1) {
+    int x = p0.x, y = p0.y;
+    int dx = abs(p1.x - p0.x), dy = -abs(p1.y - p0.y);
+    int sx = p0.x < p1.x ? 1 : -1, sy = p0.y < p1.y ? 1 : -1;
+    int error = dx + dy;
+
+    for (;;) {
+        stroke_dot(ctx, x, y);
+        if (x == p1.x && y == p1.y) break;
+        int e2 = 2 * error;
+        if (e2 >= dy) { error += dy; x += sx; }
+        if (e2 <= dx) { error += dx; y += sy; }
+    }
+}
+
+// Horizontal half-width of a circle of the given radius at a row offset
+static int circle_half_width(int radius, int dy) {
+    int half = 0;
+    while ((half + 1) * (half + 1) + dy * dy <= radius * radius) {
+        half++;
+    }
+    return half;
+}
+
+// Drawing primitives
+
+void sim_graphics_fill_background(GContext *ctx, GColor color) {
+    if (!s_framebuffer) return;
+
+    for (int y = 0; y < ctx->clip.size.h; y++) {
+        fill_span(ctx, 0, ctx->clip.size.w - 1, y, color);
+    }
+}
+
+void graphics_draw_pixel(GContext *ctx, GPoint point) {
+    count_draw(ctx, SIM_DRAW_PIXEL, GRect(point.x, point.y, 1, 1), ctx->stroke_color);
+    if (!s_framebuffer) return;
+
+    put_pixel(ctx, point.x, point.y, ctx->stroke_color);
+}
+
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1) {
+    GRect box = GRect(p0.x < p1.x ? p0.x : p1.x, p0.y < p1.y ? p0.y : p1.y,
+                      abs(p1.x - p0.x) + 1, abs(p1.y - p0.y) + 1);
+    count_draw(ctx, SIM_DRAW_LINE, box, ctx->stroke_color);
+    if (!s_framebuffer) return;
+
+    stroke_line(ctx, p0, p1);
+}
+
+void graphics_draw_rect(GContext *ctx, GRect rect) {
+    count_draw(ctx, SIM_DRAW_RECT, rect, ctx->stroke_color);
+    if (!s_framebuffer || rect.size.w <= 0 || rect.size.h <= 0) return;
+
+    int x0 = rect.origin.x, y0 = rect.origin.y;
+    int x1 = x0 + rect.size.w - 1, y1 = y0 + rect.size.h - 1;
+    fill_span(ctx, x0, x1, y0, ctx->stroke_color);
+    fill_span(ctx, x0, x1, y1, ctx->stroke_color);
+    for (int y = y0 + 1; y < y1; y++) {
+        put_pixel(ctx, x0, y, ctx->stroke_color);
+        put_pixel(ctx, x1, y, ctx->stroke_color);
+    }
+}
+
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+    count_draw(ctx, SIM_FILL_RECT, rect, ctx->fill_color);
+    if (!s_framebuffer || rect.size.w <= 0 || rect.size.h <= 0) return;
+
+    int radius = corner_radius;
+    if (radius * 2 > rect.size.w) radius = rect.size.w / 2;
+    if (radius * 2 > rect.size.h) radius = rect.size.h / 2;
+
+    for (int row = 0; row < rect.size.h; row++) {
+        int inset_left = 0, inset_right = 0;
+
+        // Rows within a corner radius are narrowed by the corner's arc
+        int dy = -1;
+        GCornerMask left = GCornerNone, right = GCornerNone;
+        if (row < radius) {
+            dy = radius - row;
+            left = GCornerTopLeft;
+            right = GCornerTopRight;
+        } else if (row >= rect.size.h - radius) {
+            dy = row - (rect.size.h - radius - 1);
+            left = GCornerBottomLeft;
+            right = GCornerBottomRight;
+        }
+        if (dy > 0) {
+            int inset = radius - circle_half_width(radius, dy);
+            if (corner_mask & left) inset_left = inset;
+            if (corner_mask & right) inset_right = inset;
+        }
+
+        fill_span(ctx, rect.origin.x + inset_left, rect.origin.x + rect.size.w - 1 - inset_right,
+                  rect.origin.y + row, ctx->fill_color);
+    }
+}
+
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius) {
+    count_draw(ctx, SIM_DRAW_CIRCLE, GRect(p.x - radius, p.y - radius, radius * 2 + 1, radius * 2 + 1),
+               ctx->stroke_color);
+    if (!s_framebuffer) return;
+
+    // Midpoint circle, one dot per octant step
+    int x = radius, y = 0, error = 1 - x;
+    while (x >= y) {
+        stroke_dot(ctx, p.x + x, p.y + y); stroke_dot(ctx, p.x - x, p.y + y);
+        stroke_dot(ctx, p.x + x, p.y - y); stroke_dot(ctx, p.x - x, p.y - y);
+        stroke_dot(ctx, p.x + y, p.y + x); stroke_dot(ctx, p.x - y, p.y + x);
+        stroke_dot(ctx, p.x + y, p.y - x); stroke_dot(ctx, p.x - y, p.y - x);
+        y++;
+        if (error < 0) {
+            error += 2 * y + 1;
+        } else {
+            x--;
+            error += 2 * (y - x) + 1;
+        }
+    }
+}
+
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius) {
+    count_draw(ctx, SIM_FILL_CIRCLE, GRect(p.x - radius, p.y - radius, radius * 2 + 1, radius * 2 + 1),
+               ctx->fill_color);
+    if (!s_framebuffer) return;
+
+    for (int dy = -radius; dy <= radius; dy++) {
+        int half = circle_half_width(radius, dy);
+        fill_span(ctx, p.x - half, p.x + half, p.y + dy, ctx->fill_color);
+    }
+}
+
+// Text
+// System fonts are stood in for by the 5x7 glyphs scaled to about half
+// the font's line height, so layouts wrap and truncate at similar widths.
+
+typedef struct {
+    int glyph_height;
+    int glyph_width;
+    int advance;
+    int line_height;
+} TextMetrics;
+
+static TextMetrics text_metrics(GFont font) {
+    TextMetrics metrics;
+    metrics.line_height = font->height;
+    metrics.glyph_height = font->height / 2;
+    metrics.glyph_width = (metrics.glyph_height * GLYPH_COLUMNS + GLYPH_ROWS / 2) / GLYPH_ROWS;
+    metrics.advance = metrics.glyph_width + 1 + metrics.glyph_width / 5 + (font->bold ? 1 : 0);
+    return metrics;
+}
+
+static int text_width(const TextMetrics *metrics, const char *text, size_t length) {
+    return length > 0 ? (int)length * metrics->advance - (metrics->advance - metrics->glyph_width) : 0;
+}
+
+static void draw_glyph(GContext *ctx, const TextMetrics *metrics, GFont font, char c, int x, int y) {
+    if (c < 0x20 || c > 0x7E) c = '?';
+    const uint8_t *columns = GLYPHS[c - 0x20];
+
+    for (int py = 0; py < metrics->glyph_height; py++) {
+        int row = py * GLYPH_ROWS / metrics->glyph_height;
+        for (int px = 0; px < metrics->glyph_width; px++) {
+            int column = px * GLYPH_COLUMNS / metrics->glyph_width;
+            if (columns[column] & (1 << row)) {
+                put_pixel(ctx, x + px, y + py, ctx->text_color);
+                if (font->bold) put_pixel(ctx, x + px + 1, y + py, ctx->text_color);
+            }
+        }
+    }
+}
+
+static void draw_text_line(GContext *ctx, const TextMetrics *metrics, GFont font, const char *text,
+                           size_t length, bool ellipsis, GRect box, GTextAlignment alignment, int y) {
+    int width = text_width(metrics, text, length + (ellipsis ? 3 : 0));
+    int x = box.origin.x;
+    if (alignment == GTextAlignmentCenter) {
+        x += (box.size.w - width) / 2;
+    } else if (alignment == GTextAlignmentRight) {
+        x += box.size.w - width;
+    }
+
+    // Glyphs sit centered in the line, a little above the middle like the system fonts
+    int glyph_y = y + (metrics->line_height - metrics->glyph_height) / 3;
+    for (size_t i = 0; i < length; i++) {
+        draw_glyph(ctx, metrics, font, text[i], x, glyph_y);
+        x += metrics->advance;
+    }
+    for (int i = 0; ellipsis && i < 3; i++) {
+        draw_glyph(ctx, metrics, font, '.', x, glyph_y);
+        x += metrics->advance;
+    }
+}
+
+// Length of the next line starting at text: whole words up to the box width
+static size_t wrap_line(const TextMetrics *metrics, const char *text, int max_width) {
+    size_t length = strcspn(text, "\n");
+    size_t fit = 0;
+    size_t last_space = 0;
+
+    while (fit < length && text_width(metrics, text, fit + 1) <= max_width) {
+        fit++;
+        if (text[fit] == ' ') last_space = fit;
+    }
+    if (fit == length) return length;
+
+    // Break at the last space, or mid-word if the word is too long
+    if (last_space > 0) return last_space;
+    return fit > 0 ? fit : 1;
+}
+
+static void rasterize_text(GContext *ctx, const char *text, GFont font, GRect box,
+                           GTextOverflowMode overflow_mode, GTextAlignment alignment) {
+    TextMetrics metrics = text_metrics(font);
+    int max_lines = box.size.h / metrics.line_height;
+    if (max_lines < 1) max_lines = 1;
+
+    int y = box.origin.y;
+    for (int line = 0; line < max_lines && *text; line++) {
+        size_t length = wrap_line(&metrics, text, box.size.w);
+        const char *rest = text + length;
+        while (*rest == ' ' || *rest == '\n') rest++;
+
+        // Text that doesn't fit ends in an ellipsis on the last line
+        bool truncated = (*rest != '\0') && (line == max_lines - 1);
+        if (truncated && overflow_mode != GTextOverflowModeWordWrap) {
+            length = strlen(text);
+            while (length > 0 && text_width(&metrics, text, length + 3) > box.size.w) {
+                length--;
+            }
+            while (length > 0 && text[length - 1] == ' ') length--;
+            draw_text_line(ctx, &metrics, font, text, length, true, box, alignment, y);
+            return;
+        }
+
+        draw_text_line(ctx, &metrics, font, text, length, false, box, alignment, y);
+        text = rest;
+        y += metrics.line_height;
+    }
+}
+
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes) {
+    g_sim_counters.draw_calls++;
+    g_sim_counters.text_draws++;
+    if (s_draw_observer) {
+        SimDrawCall call = {
+            .kind = SIM_DRAW_TEXT,
+            .rect = GRect(box.origin.x + ctx->offset.x, box.origin.y + ctx->offset.y,
+                          box.size.w, box.size.h),
+            .color = ctx->text_color,
+            .text = text,
+            .font = font,
+            .alignment = alignment
+        };
+        s_draw_observer(&call);
+    }
+    if (!s_framebuffer || !text) return;
+
+    rasterize_text(ctx, text, font, box, overflow_mode, alignment);
+}
@@ -0,0 +1,1198 @@
+#define SIM_INTERNAL
+#include <stdarg.h>
+#include <math.h>
+#include "fake_pebble.h"
+
+SimCounters g_sim_counters;
+
+void sim_counters_reset(void) {
+    memset(&g_sim_counters, 0, sizeof(g_sim_counters));
+}
+
+// Clock and settings
+
+static int64_t s_now_ms;
+static bool s_24h_style = false;
+static int s_quiet_start = -1;
+static int s_quiet_end = -1;
+static bool s_verbose = false;
+
+void sim_set_time(time_t now) {
+    s_now_ms = (int64_t)now * 1000;
+}
+
+time_t sim_now(void) {
+    return (time_t)(s_now_ms / 1000);
+}
+
+int64_t sim_now_ms(void) {
+    return s_now_ms;
+}
+
+void sim_set_24h_style(bool is_24h) {
+    s_24h_style = is_24h;
+}
+
+void sim_set_quiet_time(int start_hour, int end_hour) {
+    s_quiet_start = start_hour;
+    s_quiet_end = end_hour;
+}
+
+void sim_set_verbose(bool verbose) {
+    s_verbose = verbose;
+}
+
+void sim_log(uint8_t level, const char *file, int line, const char *fmt, ...) {
+    if (!s_verbose) return;
+
+    time_t now = sim_now();
+    char stamp[32];
+    strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+
+    const char *base = strrchr(file, '/');
+    fprintf(stderr, "[%s] %s:%d ", stamp, base ? base + 1 : file, line);
+
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+int sim_snprintf(char *buffer, size_t size, const char *fmt, ...) {
+    g_sim_counters.snprintf_calls++;
+
+    va_list args;
+    va_start(args, fmt);
+    int result = vsnprintf(buffer, size, fmt, args);
+    va_end(args);
+    return result;
+}
+
+time_t sim_time(time_t *tloc) {
+    time_t now = sim_now();
+    if (tloc) *tloc = now;
+    return now;
+}
+
+time_t time_start_of_today(void) {
+    time_t now = sim_now();
+    struct tm midnight = *localtime(&now);
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    midnight.tm_isdst = -1;
+    return mktime(&midnight);
+}
+
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms) {
+    uint16_t ms = (uint16_t)(s_now_ms % 1000);
+    if (tloc) *tloc = sim_now();
+    if (out_ms) *out_ms = ms;
+    return ms;
+}
+
+bool clock_is_24h_style(void) {
+    return s_24h_style;
+}
+
+bool quiet_time_is_active(void) {
+    if (s_quiet_start < 0) return false;
+
+    time_t now = sim_now();
+    int hour = localtime(&now)->tm_hour;
+    if (s_quiet_start <= s_quiet_end) {
+        return hour >= s_quiet_start && hour < s_quiet_end;
+    }
+    return hour >= s_quiet_start || hour < s_quiet_end;
+}
+
+// Event queue
+// Timers, message deliveries and driver events share one list ordered by
+// time, then by scheduling order.
+
+typedef enum {
+    EVENT_DRIVER,
+    EVENT_APP_TIMER,
+    EVENT_INBOX,
+    EVENT_OUTBOX_SENT
+} EventKind;
+
+typedef struct SimEvent {
+    int64_t at_ms;
+    uint64_t seq;
+    EventKind kind;
+    SimEventCallback callback;
+    void *data;
+    struct SimEvent *next;
+} SimEvent;
+
+struct AppTimer {
+    SimEvent event;
+    AppTimerCallback callback;
+    void *callback_data;
+};
+
+static SimEvent *s_events;
+static uint64_t s_event_seq;
+
+static void event_insert(SimEvent *event) {
+    event->seq = s_event_seq++;
+    SimEvent **link = &s_events;
+    while (*link && (*link)->at_ms <= event->at_ms) {
+        link = &(*link)->next;
+    }
+    event->next = *link;
+    *link = event;
+}
+
+static bool event_remove(SimEvent *event) {
+    for (SimEvent **link = &s_events; *link; link = &(*link)->next) {
+        if (*link == event) {
+            *link = event->next;
+            event->next = NULL;
+            return true;
+        }
+    }
+    return false;
+}
+
+void sim_schedule(int64_t at_ms, SimEventCallback callback, void *data) {
+    SimEvent *event = calloc(1, sizeof(SimEvent));
+    event->at_ms = at_ms;
+    event->kind = EVENT_DRIVER;
+    event->callback = callback;
+    event->data = data;
+    event_insert(event);
+}
+
+// App timers
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+    AppTimer *timer = calloc(1, sizeof(AppTimer));
+    timer->event.at_ms = s_now_ms + timeout_ms;
+    timer->event.kind = EVENT_APP_TIMER;
+    timer->event.data = timer;
+    timer->callback = callback;
+    timer->callback_data = callback_data;
+    event_insert(&timer->event);
+    return timer;
+}
+
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms) {
+    if (!timer || !event_remove(&timer->event)) return false;
+    timer->event.at_ms = s_now_ms + new_timeout_ms;
+    event_insert(&timer->event);
+    return true;
+}
+
+void app_timer_cancel(AppTimer *timer) {
+    if (timer && event_remove(&timer->event)) {
+        free(timer);
+    }
+}
+
+// Tick timer service
+
+static TickHandler s_tick_handler;
+static TimeUnits s_tick_units;
+static struct tm s_last_tick;
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler) {
+    time_t now = sim_now();
+    s_tick_units = tick_units;
+    s_tick_handler = handler;
+    s_last_tick = *localtime(&now);
+}
+
+void tick_timer_service_unsubscribe(void) {
+    s_tick_handler = NULL;
+}
+
+// Next boundary of the smallest subscribed unit
+static int64_t next_tick_ms(void) {
+    if (!s_tick_handler) return INT64_MAX;
+
+    int64_t step = 1;
+    if (!(s_tick_units & SECOND_UNIT)) {
+        step = (s_tick_units & MINUTE_UNIT) ? 60 : 3600;
+    }
+    int64_t now = s_now_ms / 1000;
+    return (now / step + 1) * step * 1000;
+}
+
+static void dispatch_tick(void) {
+    time_t now = sim_now();
+    struct tm tick_time = *localtime(&now);
+
+    TimeUnits changed = SECOND_UNIT;
+    if (tick_time.tm_min != s_last_tick.tm_min) changed |= MINUTE_UNIT;
+    if (tick_time.tm_hour != s_last_tick.tm_hour) changed |= HOUR_UNIT;
+    if (tick_time.tm_mday != s_last_tick.tm_mday) changed |= DAY_UNIT;
+    if (tick_time.tm_mon != s_last_tick.tm_mon) changed |= MONTH_UNIT;
+    if (tick_time.tm_year != s_last_tick.tm_year) changed |= YEAR_UNIT;
+    s_last_tick = tick_time;
+
+    if (!(changed & s_tick_units)) return;
+
+    g_sim_counters.wakeups++;
+    g_sim_counters.ticks++;
+    s_tick_handler(&tick_time, changed);
+}
+
+// Persistent storage
+
+#define PERSIST_MAX_KEYS 64
+
+typedef struct {
+    uint32_t key;
+    bool used;
+    uint16_t size;
+    uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} PersistEntry;
+
+static PersistEntry s_persist[PERSIST_MAX_KEYS];
+
+static PersistEntry* persist_find(uint32_t key) {
+    for (int i = 0; i < PERSIST_MAX_KEYS; i++) {
+        if (s_persist[i].used && s_persist[i].key == key) {
+            return &s_persist[i];
+        }
+    }
+    return NULL;
+}
+
+bool persist_exists(uint32_t key) {
+    return persist_find(key) != NULL;
+}
+
+int32_t persist_read_int(uint32_t key) {
+    int32_t value = 0;
+    PersistEntry *entry = persist_find(key);
+    if (entry) {
+        memcpy(&value, entry->data, entry->size < sizeof(value) ? entry->size : sizeof(value));
+    }
+    return value;
+}
+
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size) {
+    PersistEntry *entry = persist_find(key);
+    if (!entry) return -1;
+
+    size_t size = entry->size < buffer_size ? entry->size : buffer_size;
+    memcpy(buffer, entry->data, size);
+    return (int)size;
+}
+
+int persist_write_data(uint32_t key, const void *data, size_t size) {
+    PersistEntry *entry = persist_find(key);
+    for (int i = 0; !entry && i < PERSIST_MAX_KEYS; i++) {
+        if (!s_persist[i].used) {
+            entry = &s_persist[i];
+            entry->used = true;
+            entry->key = key;
+        }
+    }
+    if (!entry) return -1;
+
+    if (size > PERSIST_DATA_MAX_LENGTH) size = PERSIST_DATA_MAX_LENGTH;
+    memcpy(entry->data, data, size);
+    entry->size = (uint16_t)size;
+
+    g_sim_counters.persist_writes++;
+    g_sim_counters.persist_bytes += size;
+    return (int)size;
+}
+
+int persist_write_int(uint32_t key, int32_t value) {
+    return persist_write_data(key, &value, sizeof(value));
+}
+
+int persist_delete(uint32_t key) {
+    PersistEntry *entry = persist_find(key);
+    if (!entry) return -1;
+
+    entry->used = false;
+    g_sim_counters.persist_writes++;
+    return 0;
+}
+
+// Vibration
+
+void vibes_enqueue_custom_pattern(VibePattern pattern) {
+    g_sim_counters.vibrations++;
+}
+
+void vibes_short_pulse(void) {
+    g_sim_counters.vibrations++;
+}
+
+// Dictionaries
+
+void sim_dict_init(DictionaryIterator *iter) {
+    memset(iter, 0, sizeof(DictionaryIterator));
+}
+
+uint32_t sim_dict_size(const DictionaryIterator *iter) {
+    // One count byte, then a 7-byte header per tuple
+    uint32_t size = 1;
+    for (int i = 0; i < iter->count; i++) {
+        size += 7 + iter->tuples[i].length;
+    }
+    return size;
+}
+
+Tuple* dict_find(const DictionaryIterator *iter, const uint32_t key) {
+    for (int i = 0; i < iter->count; i++) {
+        if (iter->tuples[i].key == key) {
+            return (Tuple *)&iter->tuples[i];
+        }
+    }
+    return NULL;
+}
+
+static Tuple* dict_add(DictionaryIterator *iter, uint32_t key, TupleType type, uint16_t length) {
+    if (iter->count >= SIM_DICT_MAX_TUPLES || iter->used + length > SIM_DICT_STORAGE) {
+        return NULL;
+    }
+    Tuple *tuple = &iter->tuples[iter->count++];
+    tuple->key = key;
+    tuple->type = type;
+    tuple->length = length;
+    return tuple;
+}
+
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value) {
+    Tuple *tuple = dict_add(iter, key, TUPLE_INT, sizeof(int32_t));
+    if (!tuple) return DICT_NOT_ENOUGH_STORAGE;
+    tuple->value->int32 = value;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value) {
+    Tuple *tuple = dict_add(iter, key, TUPLE_INT, sizeof(int8_t));
+    if (!tuple) return DICT_NOT_ENOUGH_STORAGE;
+    // Widen so int32 reads see the same value, as they do on the phone side
+    tuple->value->int32 = value;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+    Tuple *tuple = dict_add(iter, key, TUPLE_UINT, sizeof(uint8_t));
+    if (!tuple) return DICT_NOT_ENOUGH_STORAGE;
+    tuple->value->uint32 = value;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data,
+                                 const uint16_t size) {
+    Tuple *tuple = dict_add(iter, key, TUPLE_BYTE_ARRAY, size);
+    if (!tuple) return DICT_NOT_ENOUGH_STORAGE;
+    tuple->value->data = &iter->storage[iter->used];
+    memcpy(tuple->value->data, data, size);
+    iter->used += size;
+    return DICT_OK;
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char * const cstring) {
+    uint16_t size = (uint16_t)strlen(cstring) + 1;
+    Tuple *tuple = dict_add(iter, key, TUPLE_CSTRING, size);
+    if (!tuple) return DICT_NOT_ENOUGH_STORAGE;
+    tuple->value->cstring = (char *)&iter->storage[iter->used];
+    memcpy(tuple->value->cstring, cstring, size);
+    iter->used += size;
+    return DICT_OK;
+}
+
+// Copy a dictionary, moving pointers into its storage along with it
+static void dict_copy(DictionaryIterator *dest, const DictionaryIterator *src) {
+    memcpy(dest, src, sizeof(DictionaryIterator));
+    for (int i = 0; i < dest->count; i++) {
+        Tuple *tuple = &dest->tuples[i];
+        if (tuple->type == TUPLE_BYTE_ARRAY || tuple->type == TUPLE_CSTRING) {
+            tuple->value->data = dest->storage + (tuple->value->data - src->storage);
+        }
+    }
+}
+
+// AppMessage
+
+static AppMessageInboxReceived s_inbox_received;
+static AppMessageInboxDropped s_inbox_dropped;
+static AppMessageOutboxSent s_outbox_sent;
+static AppMessageOutboxFailed s_outbox_failed;
+static uint32_t s_inbox_size;
+static uint32_t s_outbox_size;
+static bool s_outbox_open;
+static bool s_outbox_in_flight;
+static DictionaryIterator s_outbox;
+static uint32_t s_message_latency_ms = 100;
+static void (*s_phone_handler)(const DictionaryIterator *message);
+
+void sim_set_phone_handler(void (*handler)(const DictionaryIterator *message)) {
+    s_phone_handler = handler;
+}
+
+void sim_set_message_latency(uint32_t latency_ms) {
+    s_message_latency_ms = latency_ms;
+}
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+    s_inbox_size = size_inbound;
+    s_outbox_size = size_outbound;
+    return APP_MSG_OK;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+    AppMessageInboxReceived previous = s_inbox_received;
+    s_inbox_received = received_callback;
+    return previous;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+    AppMessageInboxDropped previous = s_inbox_dropped;
+    s_inbox_dropped = dropped_callback;
+    return previous;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+    AppMessageOutboxSent previous = s_outbox_sent;
+    s_outbox_sent = sent_callback;
+    return previous;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+    AppMessageOutboxFailed previous = s_outbox_failed;
+    s_outbox_failed = failed_callback;
+    return previous;
+}
+
+void app_message_deregister_callbacks(void) {
+    s_inbox_received = NULL;
+    s_inbox_dropped = NULL;
+    s_outbox_sent = NULL;
+    s_outbox_failed = NULL;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+    if (s_outbox_in_flight || s_outbox_open) {
+        return APP_MSG_BUSY;
+    }
+    sim_dict_init(&s_outbox);
+    s_outbox_open = true;
+    *iterator = &s_outbox;
+    return APP_MSG_OK;
+}
+
+// The phone acknowledges a message one latency after it was sent
+static void outbox_delivered(void *data) {
+    DictionaryIterator *message = data;
+    s_outbox_in_flight = false;
+
+    if (s_phone_handler) {
+        s_phone_handler(message);
+    }
+    if (s_outbox_sent) {
+        g_sim_counters.wakeups++;
+        s_outbox_sent(message, NULL);
+    }
+    free(message);
+}
+
+AppMessageResult app_message_outbox_send(void) {
+    if (!s_outbox_open) {
+        return APP_MSG_INVALID_ARGS;
+    }
+    s_outbox_open = false;
+
+    if (sim_dict_size(&s_outbox) > s_outbox_size) {
+        return APP_MSG_BUFFER_OVERFLOW;
+    }
+
+    g_sim_counters.outbox_messages++;
+    s_outbox_in_flight = true;
+
+    SimEvent *event = calloc(1, sizeof(SimEvent));
+    DictionaryIterator *message = malloc(sizeof(DictionaryIterator));
+    dict_copy(message, &s_outbox);
+    event->at_ms = s_now_ms + s_message_latency_ms;
+    event->kind = EVENT_OUTBOX_SENT;
+    event->callback = outbox_delivered;
+    event->data = message;
+    event_insert(event);
+    return APP_MSG_OK;
+}
+
+static void inbox_delivered(void *data) {
+    DictionaryIterator *message = data;
+
+    if (sim_dict_size(message) > s_inbox_size) {
+        if (s_inbox_dropped) {
+            g_sim_counters.wakeups++;
+            s_inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+        }
+    } else if (s_inbox_received) {
+        g_sim_counters.wakeups++;
+        g_sim_counters.inbox_messages++;
+        s_inbox_received(message, NULL);
+    }
+    free(message);
+}
+
+void sim_phone_send(const DictionaryIterator *message, uint32_t delay_ms) {
+    SimEvent *event = calloc(1, sizeof(SimEvent));
+    DictionaryIterator *copy = malloc(sizeof(DictionaryIterator));
+    dict_copy(copy, message);
+    event->at_ms = s_now_ms + delay_ms;
+    event->kind = EVENT_INBOX;
+    event->callback = inbox_delivered;
+    event->data = copy;
+    event_insert(event);
+}
+
+// Trigonometry
+
+int32_t sin_lookup(int32_t angle) {
+    return (int32_t)lround(sin(2.0 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+int32_t cos_lookup(int32_t angle) {
+    return (int32_t)lround(cos(2.0 * M_PI * angle / TRIG_MAX_ANGLE) * TRIG_MAX_RATIO);
+}
+
+// Compass
+
+static bool s_has_compass;
+static CompassHeadingData s_compass;
+static CompassHeadingHandler s_compass_handler;
+
+void sim_set_compass(const CompassHeadingData *heading) {
+    s_has_compass = (heading != NULL);
+    if (heading) s_compass = *heading;
+}
+
+int compass_service_peek(CompassHeadingData *data) {
+    if (!s_has_compass) return -1;
+    *data = s_compass;
+    return 0;
+}
+
+int compass_service_set_heading_filter(CompassHeading filter) {
+    return s_has_compass ? 0 : -1;
+}
+
+void compass_service_subscribe(CompassHeadingHandler handler) {
+    s_compass_handler = handler;
+}
+
+void compass_service_unsubscribe(void) {
+    s_compass_handler = NULL;
+}
+
+// Intersection of two rectangles (empty if they don't overlap)
+static GRect grect_intersect(GRect a, GRect b) {
+    int16_t x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+    int16_t y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+    int16_t x1 = a.origin.x + a.size.w;
+    int16_t y1 = a.origin.y + a.size.h;
+    if (x1 > b.origin.x + b.size.w) x1 = b.origin.x + b.size.w;
+    if (y1 > b.origin.y + b.size.h) y1 = b.origin.y + b.size.h;
+    if (x1 <= x0 || y1 <= y0) return GRectZero;
+    return GRect(x0, y0, x1 - x0, y1 - y0);
+}
+
+// Layers
+
+struct Layer {
+    GRect frame;
+    GRect bounds;
+    LayerUpdateProc update_proc;
+    Layer *parent;
+    Layer *first_child;
+    Layer *next_sibling;
+    Window *window;     // Set on window root layers only
+    bool hidden;
+};
+
+struct Window {
+    Layer root;
+    GColor background_color;
+    WindowHandlers handlers;
+    ClickConfigProvider click_config_provider;
+    void *click_context;
+    ClickHandler click_handlers[NUM_BUTTONS];
+    MenuLayer *menu_layer;
+    bool loaded;
+    bool dirty;
+};
+
+static void layer_init(Layer *layer, GRect frame) {
+    memset(layer, 0, sizeof(Layer));
+    layer->frame = frame;
+    layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+}
+
+Layer* layer_create(GRect frame) {
+    Layer *layer = malloc(sizeof(Layer));
+    layer_init(layer, frame);
+    return layer;
+}
+
+static void layer_deinit(Layer *layer) {
+    layer_remove_from_parent(layer);
+    for (Layer *child = layer->first_child; child; ) {
+        Layer *next = child->next_sibling;
+        child->parent = NULL;
+        child->next_sibling = NULL;
+        child = next;
+    }
+}
+
+void layer_destroy(Layer *layer) {
+    if (!layer) return;
+    layer_deinit(layer);
+    free(layer);
+}
+
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc) {
+    layer->update_proc = update_proc;
+}
+
+Window* layer_get_window(const Layer *layer) {
+    while (layer && layer->parent) {
+        layer = layer->parent;
+    }
+    return layer ? layer->window : NULL;
+}
+
+void layer_mark_dirty(Layer *layer) {
+    Window *window = layer_get_window(layer);
+    if (window) {
+        window->dirty = true;
+    }
+}
+
+void layer_add_child(Layer *parent, Layer *child) {
+    layer_remove_from_parent(child);
+    child->parent = parent;
+
+    Layer **link = &parent->first_child;
+    while (*link) {
+        link = &(*link)->next_sibling;
+    }
+    *link = child;
+    layer_mark_dirty(parent);
+}
+
+void layer_remove_from_parent(Layer *child) {
+    if (!child->parent) return;
+
+    layer_mark_dirty(child->parent);
+    for (Layer **link = &child->parent->first_child; *link; link = &(*link)->next_sibling) {
+        if (*link == child) {
+            *link = child->next_sibling;
+            break;
+        }
+    }
+    child->parent = NULL;
+    child->next_sibling = NULL;
+}
+
+GRect layer_get_bounds(const Layer *layer) {
+    return layer->bounds;
+}
+
+GRect layer_get_frame(const Layer *layer) {
+    return layer->frame;
+}
+
+void layer_set_hidden(Layer *layer, bool hidden) {
+    if (layer->hidden != hidden) {
+        layer->hidden = hidden;
+        layer_mark_dirty(layer);
+    }
+}
+
+GPoint grect_center_point(const GRect *rect) {
+    return GPoint(rect->origin.x + rect->size.w / 2, rect->origin.y + rect->size.h / 2);
+}
+
+// Text layer
+
+struct TextLayer {
+    Layer layer;
+    const char *text;
+    GFont font;
+    GColor text_color;
+    GColor background_color;
+    GTextAlignment alignment;
+    GTextOverflowMode overflow_mode;
+};
+
+static void text_layer_update_proc(Layer *layer, GContext *ctx) {
+    TextLayer *text_layer = (TextLayer *)layer;
+
+    if (text_layer->background_color.a != 0) {
+        graphics_context_set_fill_color(ctx, text_layer->background_color);
+        graphics_fill_rect(ctx, layer->bounds, 0, GCornerNone);
+    }
+    if (text_layer->text && text_layer->text[0]) {
+        graphics_context_set_text_color(ctx, text_layer->text_color);
+        graphics_draw_text(ctx, text_layer->text, text_layer->font, layer->bounds,
+                           text_layer->overflow_mode, text_layer->alignment, NULL);
+    }
+}
+
+TextLayer* text_layer_create(GRect frame) {
+    TextLayer *text_layer = calloc(1, sizeof(TextLayer));
+    layer_init(&text_layer->layer, frame);
+    text_layer->layer.update_proc = text_layer_update_proc;
+    text_layer->font = fonts_get_system_font(FONT_KEY_GOTHIC_14);
+    text_layer->text_color = GColorBlack;
+    text_layer->background_color = GColorWhite;
+    text_layer->alignment = GTextAlignmentLeft;
+    text_layer->overflow_mode = GTextOverflowModeWordWrap;
+    return text_layer;
+}
+
+void text_layer_destroy(TextLayer *text_layer) {
+    if (!text_layer) return;
+    layer_deinit(&text_layer->layer);
+    free(text_layer);
+}
+
+Layer* text_layer_get_layer(TextLayer *text_layer) {
+    return &text_layer->layer;
+}
+
+void text_layer_set_text(TextLayer *text_layer, const char *text) {
+    text_layer->text = text;
+    layer_mark_dirty(&text_layer->layer);
+}
+
+const char* text_layer_get_text(TextLayer *text_layer) {
+    return text_layer->text;
+}
+
+void text_layer_set_background_color(TextLayer *text_layer, GColor color) {
+    text_layer->background_color = color;
+    layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_text_color(TextLayer *text_layer, GColor color) {
+    text_layer->text_color = color;
+    layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_font(TextLayer *text_layer, GFont font) {
+    text_layer->font = font;
+    layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment) {
+    text_layer->alignment = text_alignment;
+    layer_mark_dirty(&text_layer->layer);
+}
+
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode) {
+    text_layer->overflow_mode = line_mode;
+    layer_mark_dirty(&text_layer->layer);
+}
+
+// Menu layer (one section, rows drawn top down from the scroll offset)
+
+#define MENU_DEFAULT_CELL_HEIGHT 44
+
+struct MenuLayer {
+    Layer layer;
+    MenuLayerCallbacks callbacks;
+    void *callback_context;
+    GColor normal_background;
+    GColor normal_foreground;
+    GColor highlight_background;
+    GColor highlight_foreground;
+    uint16_t selected_row;
+    int16_t scroll_offset;
+};
+
+static uint16_t menu_num_rows(MenuLayer *menu_layer) {
+    if (!menu_layer->callbacks.get_num_rows) return 0;
+    return menu_layer->callbacks.get_num_rows(menu_layer, 0, menu_layer->callback_context);
+}
+
+static int16_t menu_cell_height(MenuLayer *menu_layer, uint16_t row) {
+    if (!menu_layer->callbacks.get_cell_height) return MENU_DEFAULT_CELL_HEIGHT;
+    MenuIndex index = { .section = 0, .row = row };
+    return menu_layer->callbacks.get_cell_height(menu_layer, &index, menu_layer->callback_context);
+}
+
+static void menu_layer_update_proc(Layer *layer, GContext *ctx) {
+    MenuLayer *menu_layer = (MenuLayer *)layer;
+    GRect bounds = layer->bounds;
+    uint16_t rows = menu_num_rows(menu_layer);
+
+    graphics_context_set_fill_color(ctx, menu_layer->normal_background);
+    graphics_fill_rect(ctx, bounds, 0, GCornerNone);
+
+    // Draw through a cell layer positioned under the menu
+    GPoint layer_offset = ctx->offset;
+    GRect layer_clip = ctx->clip;
+    int16_t y = -menu_layer->scroll_offset;
+
+    for (uint16_t row = 0; row < rows && y < bounds.size.h; row++) {
+        int16_t height = menu_cell_height(menu_layer, row);
+        if (y + height > 0 && menu_layer->callbacks.draw_row) {
+            bool highlighted = (row == menu_layer->selected_row);
+            Layer cell;
+            layer_init(&cell, GRect(0, y, bounds.size.w, height));
+
+            GRect cell_frame = GRect(layer_offset.x, layer_offset.y + y, bounds.size.w, height);
+            sim_graphics_set_layer(ctx, cell_frame, grect_intersect(cell_frame, layer_clip));
+
+            if (highlighted) {
+                graphics_context_set_fill_color(ctx, menu_layer->highlight_background);
+                graphics_fill_rect(ctx, cell.bounds, 0, GCornerNone);
+            }
+            graphics_context_set_text_color(ctx, highlighted ? menu_layer->highlight_foreground
+                                                             : menu_layer->normal_foreground);
+
+            MenuIndex index = { .section = 0, .row = row };
+            menu_layer->callbacks.draw_row(ctx, &cell, &index, menu_layer->callback_context);
+        }
+        y += height;
+    }
+}
+
+MenuLayer* menu_layer_create(GRect frame) {
+    MenuLayer *menu_layer = calloc(1, sizeof(MenuLayer));
+    layer_init(&menu_layer->layer, frame);
+    menu_layer->layer.update_proc = menu_layer_update_proc;
+    menu_layer->normal_background = GColorWhite;
+    menu_layer->normal_foreground = GColorBlack;
+    menu_layer->highlight_background = GColorBlack;
+    menu_layer->highlight_foreground = GColorWhite;
+    return menu_layer;
+}
+
+void menu_layer_destroy(MenuLayer *menu_layer) {
+    if (!menu_layer) return;
+    layer_deinit(&menu_layer->layer);
+    free(menu_layer);
+}
+
+Layer* menu_layer_get_layer(const MenuLayer *menu_layer) {
+    return (Layer *)&menu_layer->layer;
+}
+
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context, MenuLayerCallbacks callbacks) {
+    menu_layer->callbacks = callbacks;
+    menu_layer->callback_context = callback_context;
+    layer_mark_dirty(&menu_layer->layer);
+}
+
+void menu_layer_set_normal_colors(MenuLayer *menu_layer, GColor background, GColor foreground) {
+    menu_layer->normal_background = background;
+    menu_layer->normal_foreground = foreground;
+}
+
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground) {
+    menu_layer->highlight_background = background;
+    menu_layer->highlight_foreground = foreground;
+}
+
+void menu_layer_reload_data(MenuLayer *menu_layer) {
+    uint16_t rows = menu_num_rows(menu_layer);
+    if (menu_layer->selected_row >= rows) {
+        menu_layer->selected_row = rows > 0 ? rows - 1 : 0;
+    }
+    layer_mark_dirty(&menu_layer->layer);
+}
+
+// Move the selection and keep it on screen
+static void menu_layer_select(MenuLayer *menu_layer, int delta) {
+    int rows = menu_num_rows(menu_layer);
+    int row = menu_layer->selected_row + delta;
+    if (row < 0 || row >= rows) return;
+    menu_layer->selected_row = (uint16_t)row;
+
+    int16_t top = 0;
+    for (int i = 0; i < row; i++) {
+        top += menu_cell_height(menu_layer, (uint16_t)i);
+    }
+    int16_t bottom = top + menu_cell_height(menu_layer, (uint16_t)row);
+    if (top < menu_layer->scroll_offset) {
+        menu_layer->scroll_offset = top;
+    } else if (bottom > menu_layer->scroll_offset + menu_layer->layer.bounds.size.h) {
+        menu_layer->scroll_offset = bottom - menu_layer->layer.bounds.size.h;
+    }
+    layer_mark_dirty(&menu_layer->layer);
+}
+
+static void menu_up_handler(ClickRecognizerRef recognizer, void *context) {
+    menu_layer_select(((Window *)context)->menu_layer, -1);
+}
+
+static void menu_down_handler(ClickRecognizerRef recognizer, void *context) {
+    menu_layer_select(((Window *)context)->menu_layer, 1);
+}
+
+static void menu_select_handler(ClickRecognizerRef recognizer, void *context) {
+    MenuLayer *menu_layer = ((Window *)context)->menu_layer;
+    if (menu_layer->callbacks.select_click) {
+        MenuIndex index = { .section = 0, .row = menu_layer->selected_row };
+        menu_layer->callbacks.select_click(menu_layer, &index, menu_layer->callback_context);
+    }
+}
+
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window) {
+    window->menu_layer = menu_layer;
+    window->click_handlers[BUTTON_ID_UP] = menu_up_handler;
+    window->click_handlers[BUTTON_ID_DOWN] = menu_down_handler;
+    window->click_handlers[BUTTON_ID_SELECT] = menu_select_handler;
+}
+
+// Windows
+
+#define WINDOW_STACK_MAX 8
+
+static Window *s_window_stack[WINDOW_STACK_MAX];
+static int s_window_count;
+static Window *s_configuring_window;
+
+Window* window_create(void) {
+    Window *window = calloc(1, sizeof(Window));
+    layer_init(&window->root, GRect(0, 0, SIM_SCREEN_WIDTH, SIM_SCREEN_HEIGHT));
+    window->root.window = window;
+    window->background_color = GColorWhite;
+    return window;
+}
+
+void window_set_window_handlers(Window *window, WindowHandlers handlers) {
+    window->handlers = handlers;
+}
+
+void window_set_background_color(Window *window, GColor background_color) {
+    window->background_color = background_color;
+    window->dirty = true;
+}
+
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider,
+                                                   void *context) {
+    window->click_config_provider = click_config_provider;
+    window->click_context = context;
+}
+
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider) {
+    window_set_click_config_provider_with_context(window, click_config_provider, window);
+}
+
+Layer* window_get_root_layer(const Window *window) {
+    return (Layer *)&window->root;
+}
+
+bool window_is_loaded(Window *window) {
+    return window->loaded;
+}
+
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler) {
+    if (s_configuring_window && button_id < NUM_BUTTONS) {
+        s_configuring_window->click_handlers[button_id] = handler;
+    }
+}
+
+Window* window_stack_get_top_window(void) {
+    return s_window_count > 0 ? s_window_stack[s_window_count - 1] : NULL;
+}
+
+// Window becoming the top of the stack
+static void window_show(Window *window) {
+    if (!window->loaded) {
+        window->loaded = true;
+        memset(window->click_handlers, 0, sizeof(window->click_handlers));
+        window->menu_layer = NULL;
+        if (window->handlers.load) window->handlers.load(window);
+
+        if (window->click_config_provider) {
+            s_configuring_window = window;
+            window->click_config_provider(window->click_context);
+            s_configuring_window = NULL;
+        }
+    }
+    if (window->handlers.appear) window->handlers.appear(window);
+    window->dirty = true;
+}
+
+// Window leaving the stack
+static void window_remove(Window *window) {
+    if (window->handlers.unload) window->handlers.unload(window);
+    window->loaded = false;
+}
+
+void window_stack_push(Window *window, bool animated) {
+    Window *previous = window_stack_get_top_window();
+    if (previous && previous->handlers.disappear) {
+        previous->handlers.disappear(previous);
+    }
+    if (s_window_count < WINDOW_STACK_MAX) {
+        s_window_stack[s_window_count++] = window;
+    }
+    window_show(window);
+}
+
+Window* window_stack_pop(bool animated) {
+    Window *window = window_stack_get_top_window();
+    if (!window) return NULL;
+
+    if (window->handlers.disappear) window->handlers.disappear(window);
+    s_window_count--;
+    window_remove(window);
+
+    Window *top = window_stack_get_top_window();
+    if (top) window_show(top);
+    return window;
+}
+
+void window_destroy(Window *window) {
+    if (!window) return;
+
+    for (int i = 0; i < s_window_count; i++) {
+        if (s_window_stack[i] != window) continue;
+
+        if (i == s_window_count - 1 && window->handlers.disappear) {
+            window->handlers.disappear(window);
+        }
+        memmove(&s_window_stack[i], &s_window_stack[i + 1],
+                (s_window_count - i - 1) * sizeof(Window *));
+        s_window_count--;
+        window_remove(window);
+        break;
+    }
+    layer_deinit(&window->root);
+    free(window);
+}
+
+void sim_click(ButtonId button) {
+    Window *window = window_stack_get_top_window();
+    if (!window) return;
+
+    g_sim_counters.wakeups++;
+    ClickHandler handler = window->click_handlers[button];
+    if (handler) {
+        handler(NULL, window->menu_layer ? window : window->click_context);
+    } else if (button == BUTTON_ID_BACK && s_window_count > 1) {
+        window_stack_pop(true);
+    }
+}
+
+// Rendering
+
+static void render_layer(Layer *layer, GContext *ctx, GPoint origin, GRect clip) {
+    if (layer->hidden) return;
+
+    GRect frame = GRect(origin.x + layer->frame.origin.x + layer->bounds.origin.x,
+                        origin.y + layer->frame.origin.y + layer->bounds.origin.y,
+                        layer->frame.size.w, layer->frame.size.h);
+
+    // Children are clipped to their parent's frame
+    GRect layer_clip = grect_intersect(frame, clip);
+    if (layer_clip.size.w == 0) return;
+
+    if (layer->update_proc) {
+        sim_graphics_set_layer(ctx, frame, layer_clip);
+        layer->update_proc(layer, ctx);
+    }
+    for (Layer *child = layer->first_child; child; child = child->next_sibling) {
+        render_layer(child, ctx, frame.origin, layer_clip);
+    }
+}
+
+void sim_render_window(GContext *ctx) {
+    Window *window = window_stack_get_top_window();
+    if (!window) return;
+
+    GRect screen = GRect(0, 0, SIM_SCREEN_WIDTH, SIM_SCREEN_HEIGHT);
+    sim_graphics_set_layer(ctx, screen, screen);
+    sim_graphics_fill_background(ctx, window->background_color);
+    render_layer(&window->root, ctx, GPoint(0, 0), screen);
+
+    g_sim_counters.redraws++;
+    window->dirty = false;
+}
+
+void sim_render_if_dirty(void) {
+    Window *window = window_stack_get_top_window();
+    if (!window || !window->dirty) return;
+
+    GContext ctx;
+    sim_graphics_context_init(&ctx);
+    sim_render_window(&ctx);
+}
+
+// Event loop
+
+static time_t s_run_until;
+static void (*s_day_callback)(time_t midnight);
+
+void sim_set_run_until(time_t end) {
+    s_run_until = end;
+}
+
+void sim_set_day_callback(void (*callback)(time_t midnight)) {
+    s_day_callback = callback;
+}
+
+static time_t next_local_midnight(time_t now) {
+    struct tm midnight = *localtime(&now);
+    midnight.tm_mday++;
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    midnight.tm_isdst = -1;
+    return mktime(&midnight);
+}
+
+void app_event_loop(void) {
+    int64_t end_ms = (int64_t)s_run_until * 1000;
+    int64_t midnight_ms = (int64_t)next_local_midnight(sim_now()) * 1000;
+
+    sim_render_if_dirty();
+
+    while (true) {
+        // Earliest of: day boundary, queued event, tick
+        int64_t tick_ms = next_tick_ms();
+        int64_t event_ms = s_events ? s_events->at_ms : INT64_MAX;
+        int64_t next_ms = midnight_ms;
+        if (event_ms < next_ms) next_ms = event_ms;
+        if (tick_ms < next_ms) next_ms = tick_ms;
+        if (next_ms > end_ms) break;
+
+        s_now_ms = next_ms;
+
+        if (next_ms == midnight_ms) {
+            midnight_ms = (int64_t)next_local_midnight((time_t)(next_ms / 1000)) * 1000;
+            if (s_day_callback) s_day_callback((time_t)(next_ms / 1000));
+        } else if (next_ms == event_ms) {
+            SimEvent *event = s_events;
+            s_events = event->next;
+
+            if (event->kind == EVENT_APP_TIMER) {
+                AppTimer *timer = (AppTimer *)event;
+                g_sim_counters.wakeups++;
+                g_sim_counters.timers++;
+                AppTimerCallback callback = timer->callback;
+                void *data = timer->callback_data;
+                free(timer);
+                callback(data);
+            } else {
+                event->callback(event->data);
+                free(event);
+            }
+        } else {
+            dispatch_tick();
+        }
+
+        sim_render_if_dirty();
+    }
+
+    s_now_ms = end_ms;
+}
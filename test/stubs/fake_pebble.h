@@ -0,0 +1,173 @@
+#pragma once
+
+// Control side of the host Pebble fakes, used by the test drivers
+// The app only sees pebble.h; drivers use this to move the simulated
+// clock, play the phone and inspect what the app did.
+
+#include <pebble.h>
+
+// Name and screen size of the platform the fakes were built for
+#if defined(PBL_PLATFORM_EMERY)
+#define SIM_PLATFORM_NAME "emery"
+#define SIM_SCREEN_WIDTH 200
+#define SIM_SCREEN_HEIGHT 228
+#elif defined(PBL_PLATFORM_CHALK)
+#define SIM_PLATFORM_NAME "chalk"
+#define SIM_SCREEN_WIDTH 180
+#define SIM_SCREEN_HEIGHT 180
+#else
+#if defined(PBL_PLATFORM_APLITE)
+#define SIM_PLATFORM_NAME "aplite"
+#elif defined(PBL_PLATFORM_DIORITE)
+#define SIM_PLATFORM_NAME "diorite"
+#else
+#define SIM_PLATFORM_NAME "basalt"
+#endif
+#define SIM_SCREEN_WIDTH 144
+#define SIM_SCREEN_HEIGHT 168
+#endif
+
+// What the app cost, counted since the last sim_counters_reset()
+typedef struct {
+    uint32_t wakeups;           // Events delivered to the app
+    uint32_t ticks;             // ...of which tick service callbacks
+    uint32_t timers;            // ...of which app timer callbacks
+    uint32_t inbox_messages;    // ...of which received AppMessages
+    uint32_t redraws;           // Frames rendered
+    uint32_t snprintf_calls;
+    uint32_t persist_writes;    // Writes and deletes (each one is a flash write)
+    uint32_t persist_bytes;
+    uint32_t outbox_messages;
+    uint32_t vibrations;
+    uint32_t draw_calls;        // Drawing primitives, including text
+    uint32_t text_draws;
+} SimCounters;
+
+extern SimCounters g_sim_counters;
+
+void sim_counters_reset(void);
+
+// Clock
+
+// Set the wall clock (only before the app starts)
+void sim_set_time(time_t now);
+
+// Current simulated time
+time_t sim_now(void);
+int64_t sim_now_ms(void);
+
+void sim_set_24h_style(bool is_24h);
+
+// Quiet time as a daily local window [start_hour, end_hour), wrapping past midnight
+void sim_set_quiet_time(int start_hour, int end_hour);
+
+// Print APP_LOG output
+void sim_set_verbose(bool verbose);
+
+// Event loop
+
+typedef void (*SimEventCallback)(void *data);
+
+// Run a callback at an absolute simulated time (driver events, not app wakeups)
+void sim_schedule(int64_t at_ms, SimEventCallback callback, void *data);
+
+// Length of the run app_event_loop() performs
+void sim_set_run_until(time_t end);
+
+// Called once per simulated local day boundary, before events at that time
+void sim_set_day_callback(void (*callback)(time_t midnight));
+
+// Phone side of AppMessage
+
+#define SIM_DICT_MAX_TUPLES 24
+#define SIM_DICT_STORAGE 1024
+
+struct DictionaryIterator {
+    Tuple tuples[SIM_DICT_MAX_TUPLES];
+    uint8_t count;
+    uint8_t storage[SIM_DICT_STORAGE];
+    uint16_t used;
+};
+
+void sim_dict_init(DictionaryIterator *iter);
+
+// Bytes a dictionary takes on the wire, as counted against the app's buffers
+uint32_t sim_dict_size(const DictionaryIterator *iter);
+
+// Called with each message the app sends, when the phone receives it
+void sim_set_phone_handler(void (*handler)(const DictionaryIterator *message));
+
+// Deliver a message to the app's inbox after a delay (the dictionary is copied)
+void sim_phone_send(const DictionaryIterator *message, uint32_t delay_ms);
+
+// Milliseconds between the app sending and the phone acknowledging
+void sim_set_message_latency(uint32_t latency_ms);
+
+// Buttons and windows
+
+void sim_click(ButtonId button);
+
+// Render the top window now if anything on it changed
+void sim_render_if_dirty(void);
+
+// Render the top window unconditionally into the given context
+void sim_render_window(GContext *ctx);
+
+// Compass readings returned by compass_service_peek() (NULL = no compass)
+void sim_set_compass(const CompassHeadingData *heading);
+
+// Drawing context
+
+typedef struct SimFont {
+    const char *key;
+    uint8_t height;     // Line height in pixels
+    bool bold;
+} SimFont;
+
+struct GContext {
+    GColor stroke_color;
+    GColor fill_color;
+    GColor text_color;
+    uint8_t stroke_width;
+    GPoint offset;      // Origin of the layer being drawn, in screen coordinates
+    GRect clip;         // Screen area the layer may draw into
+};
+
+void sim_graphics_context_init(GContext *ctx);
+void sim_graphics_set_layer(GContext *ctx, GRect screen_frame, GRect clip);
+
+// Fill a screen rectangle as the system does for window backgrounds (not counted)
+void sim_graphics_fill_background(GContext *ctx, GColor color);
+
+// Framebuffer
+// Drawing only rasterizes while a framebuffer is attached, so long
+// simulations just count calls. Pixels are row-major, SIM_SCREEN_WIDTH x
+// SIM_SCREEN_HEIGHT; black-and-white platforms only ever write black or white.
+
+#define SIM_FRAMEBUFFER_PIXELS (SIM_SCREEN_WIDTH * SIM_SCREEN_HEIGHT)
+
+void sim_framebuffer_attach(GColor *pixels);
+
+// Drawing calls as the app made them, in screen coordinates
+
+typedef enum {
+    SIM_DRAW_PIXEL,
+    SIM_DRAW_LINE,
+    SIM_DRAW_RECT,
+    SIM_FILL_RECT,
+    SIM_DRAW_CIRCLE,
+    SIM_FILL_CIRCLE,
+    SIM_DRAW_TEXT
+} SimDrawKind;
+
+typedef struct {
+    SimDrawKind kind;
+    GRect rect;         // Box, rectangle, or bounding box of lines and circles
+    GColor color;       // Stroke, fill or text color
+    const char *text;   // Text draws only
+    GFont font;
+    GTextAlignment alignment;
+} SimDrawCall;
+
+// Called with each counted drawing call (NULL to stop)
+void sim_set_draw_observer(void (*observer)(const SimDrawCall *call));
@@ -0,0 +1,430 @@
+#pragma once
+
+// Host stand-in for the Pebble SDK header
+// Declares just the SDK surface the app uses, backed by fake_pebble.c
+// (simulated clock, services, windows) and fake_graphics.c (drawing).
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Platform
+
+#if defined(PBL_ROUND)
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_false)
+#else
+#define PBL_IF_ROUND_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_RECT_ELSE(if_true, if_false) (if_true)
+#endif
+
+#if defined(PBL_COLOR)
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_true)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_false)
+#else
+#define PBL_IF_COLOR_ELSE(if_true, if_false) (if_false)
+#define PBL_IF_BW_ELSE(if_true, if_false) (if_true)
+#endif
+
+#define ARRAY_LENGTH(array) (sizeof(array) / sizeof((array)[0]))
+
+// Logging
+
+typedef enum {
+    APP_LOG_LEVEL_ERROR = 1,
+    APP_LOG_LEVEL_WARNING = 50,
+    APP_LOG_LEVEL_INFO = 100,
+    APP_LOG_LEVEL_DEBUG = 200,
+    APP_LOG_LEVEL_DEBUG_VERBOSE = 255
+} AppLogLevel;
+
+void sim_log(uint8_t level, const char *file, int line, const char *fmt, ...)
+    __attribute__((format(printf, 4, 5)));
+
+#define APP_LOG(level, fmt, ...) sim_log(level, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
+
+// Counted and simulated libc calls (not redirected inside the fakes themselves)
+
+int sim_snprintf(char *buffer, size_t size, const char *fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+time_t sim_time(time_t *tloc);
+
+#if !defined(SIM_INTERNAL)
+#define snprintf sim_snprintf
+#define time(tloc) sim_time(tloc)
+#endif
+
+// Time
+
+typedef enum {
+    SECOND_UNIT = 1 << 0,
+    MINUTE_UNIT = 1 << 1,
+    HOUR_UNIT = 1 << 2,
+    DAY_UNIT = 1 << 3,
+    MONTH_UNIT = 1 << 4,
+    YEAR_UNIT = 1 << 5
+} TimeUnits;
+
+typedef void (*TickHandler)(struct tm *tick_time, TimeUnits units_changed);
+
+void tick_timer_service_subscribe(TimeUnits tick_units, TickHandler handler);
+void tick_timer_service_unsubscribe(void);
+
+time_t time_start_of_today(void);
+uint16_t time_ms(time_t *tloc, uint16_t *out_ms);
+bool clock_is_24h_style(void);
+bool quiet_time_is_active(void);
+
+typedef struct AppTimer AppTimer;
+typedef void (*AppTimerCallback)(void *data);
+
+AppTimer* app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data);
+bool app_timer_reschedule(AppTimer *timer, uint32_t new_timeout_ms);
+void app_timer_cancel(AppTimer *timer);
+
+// Persistent storage
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+bool persist_exists(uint32_t key);
+int32_t persist_read_int(uint32_t key);
+int persist_read_data(uint32_t key, void *buffer, size_t buffer_size);
+int persist_write_int(uint32_t key, int32_t value);
+int persist_write_data(uint32_t key, const void *data, size_t size);
+int persist_delete(uint32_t key);
+
+// Vibration
+
+typedef struct {
+    const uint32_t *durations;
+    uint32_t num_segments;
+} VibePattern;
+
+void vibes_enqueue_custom_pattern(VibePattern pattern);
+void vibes_short_pulse(void);
+
+// Dictionary and AppMessage
+
+typedef enum {
+    TUPLE_BYTE_ARRAY = 0,
+    TUPLE_CSTRING = 1,
+    TUPLE_UINT = 2,
+    TUPLE_INT = 3
+} TupleType;
+
+typedef union {
+    uint8_t *data;
+    char *cstring;
+    uint8_t uint8;
+    uint16_t uint16;
+    uint32_t uint32;
+    int8_t int8;
+    int16_t int16;
+    int32_t int32;
+} TupleValue;
+
+typedef struct {
+    uint32_t key;
+    TupleType type;
+    uint16_t length;
+    TupleValue value[1];
+} Tuple;
+
+typedef struct DictionaryIterator DictionaryIterator;
+
+typedef enum {
+    DICT_OK = 0,
+    DICT_NOT_ENOUGH_STORAGE = 1 << 1,
+    DICT_INVALID_ARGS = 1 << 2
+} DictionaryResult;
+
+Tuple* dict_find(const DictionaryIterator *iter, const uint32_t key);
+DictionaryResult dict_write_int8(DictionaryIterator *iter, const uint32_t key, const int8_t value);
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value);
+DictionaryResult dict_write_int32(DictionaryIterator *iter, const uint32_t key, const int32_t value);
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char * const cstring);
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t * const data,
+                                 const uint16_t size);
+
+typedef enum {
+    APP_MSG_OK = 0,
+    APP_MSG_SEND_TIMEOUT = 1 << 1,
+    APP_MSG_SEND_REJECTED = 1 << 2,
+    APP_MSG_NOT_CONNECTED = 1 << 3,
+    APP_MSG_APP_NOT_RUNNING = 1 << 4,
+    APP_MSG_INVALID_ARGS = 1 << 5,
+    APP_MSG_BUSY = 1 << 6,
+    APP_MSG_BUFFER_OVERFLOW = 1 << 7,
+    APP_MSG_ALREADY_RELEASED = 1 << 9,
+    APP_MSG_CALLBACK_ALREADY_REGISTERED = 1 << 10,
+    APP_MSG_CALLBACK_NOT_REGISTERED = 1 << 11,
+    APP_MSG_OUT_OF_MEMORY = 1 << 12,
+    APP_MSG_CLOSED = 1 << 13,
+    APP_MSG_INTERNAL_ERROR = 1 << 14
+} AppMessageResult;
+
+typedef void (*AppMessageInboxReceived)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageInboxDropped)(AppMessageResult reason, void *context);
+typedef void (*AppMessageOutboxSent)(DictionaryIterator *iterator, void *context);
+typedef void (*AppMessageOutboxFailed)(DictionaryIterator *iterator, AppMessageResult reason, void *context);
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound);
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback);
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback);
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback);
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback);
+void app_message_deregister_callbacks(void);
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator);
+AppMessageResult app_message_outbox_send(void);
+
+// Trigonometry
+
+#define TRIG_MAX_RATIO 0xffff
+#define TRIG_MAX_ANGLE 0x10000
+#define TRIGANGLE_TO_DEG(trig_angle) (((trig_angle) * 360) / TRIG_MAX_ANGLE)
+#define DEG_TO_TRIGANGLE(angle) (((angle) * TRIG_MAX_ANGLE) / 360)
+
+int32_t sin_lookup(int32_t angle);
+int32_t cos_lookup(int32_t angle);
+
+// Compass
+
+typedef int32_t CompassHeading;
+
+typedef enum {
+    CompassStatusDataInvalid = 0,
+    CompassStatusCalibrating,
+    CompassStatusCalibrated
+} CompassStatus;
+
+typedef struct {
+    CompassHeading magnetic_heading;
+    CompassHeading true_heading;
+    CompassStatus compass_status;
+    bool is_declination_valid;
+} CompassHeadingData;
+
+typedef void (*CompassHeadingHandler)(CompassHeadingData heading);
+
+int compass_service_peek(CompassHeadingData *data);
+int compass_service_set_heading_filter(CompassHeading filter);
+void compass_service_subscribe(CompassHeadingHandler handler);
+void compass_service_unsubscribe(void);
+
+// Graphics types
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+} GPoint;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+
+typedef struct {
+    int16_t w;
+    int16_t h;
+} GSize;
+
+#define GSize(w, h) ((GSize){(w), (h)})
+
+typedef struct {
+    GPoint origin;
+    GSize size;
+} GRect;
+
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GRectZero GRect(0, 0, 0, 0)
+
+GPoint grect_center_point(const GRect *rect);
+
+// 8-bit ARGB, two bits per channel
+typedef union {
+    uint8_t argb;
+    struct {
+        uint8_t b:2;
+        uint8_t g:2;
+        uint8_t r:2;
+        uint8_t a:2;
+    };
+} GColor8;
+
+typedef GColor8 GColor;
+
+#define GColorARGB8(value) ((GColor8){ .argb = (value) })
+
+#define GColorClear                 GColorARGB8(0x00)
+#define GColorBlack                 GColorARGB8(0xC0)
+#define GColorDarkGray              GColorARGB8(0xD5)
+#define GColorLightGray             GColorARGB8(0xEA)
+#define GColorWhite                 GColorARGB8(0xFF)
+#define GColorDarkGreen             GColorARGB8(0xC4)
+#define GColorIslamicGreen          GColorARGB8(0xC8)
+#define GColorMediumSpringGreen     GColorARGB8(0xCE)
+#define GColorRed                   GColorARGB8(0xF0)
+
+typedef enum {
+    GCornerNone = 0,
+    GCornerTopLeft = 1 << 0,
+    GCornerTopRight = 1 << 1,
+    GCornerBottomLeft = 1 << 2,
+    GCornerBottomRight = 1 << 3,
+    GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight
+} GCornerMask;
+
+typedef enum {
+    GTextAlignmentLeft = 0,
+    GTextAlignmentCenter,
+    GTextAlignmentRight
+} GTextAlignment;
+
+typedef enum {
+    GTextOverflowModeWordWrap = 0,
+    GTextOverflowModeTrailingEllipsis,
+    GTextOverflowModeFill
+} GTextOverflowMode;
+
+typedef struct GTextAttributes GTextAttributes;
+typedef struct GContext GContext;
+typedef const struct SimFont *GFont;
+
+// Fonts
+
+#define FONT_KEY_GOTHIC_14 "RESOURCE_ID_GOTHIC_14"
+#define FONT_KEY_GOTHIC_14_BOLD "RESOURCE_ID_GOTHIC_14_BOLD"
+#define FONT_KEY_GOTHIC_18 "RESOURCE_ID_GOTHIC_18"
+#define FONT_KEY_GOTHIC_18_BOLD "RESOURCE_ID_GOTHIC_18_BOLD"
+#define FONT_KEY_GOTHIC_24 "RESOURCE_ID_GOTHIC_24"
+#define FONT_KEY_GOTHIC_24_BOLD "RESOURCE_ID_GOTHIC_24_BOLD"
+#define FONT_KEY_GOTHIC_28_BOLD "RESOURCE_ID_GOTHIC_28_BOLD"
+#define FONT_KEY_BITHAM_30_BLACK "RESOURCE_ID_BITHAM_30_BLACK"
+#define FONT_KEY_BITHAM_42_BOLD "RESOURCE_ID_BITHAM_42_BOLD"
+
+GFont fonts_get_system_font(const char *font_key);
+
+// Drawing
+
+void graphics_context_set_stroke_color(GContext *ctx, GColor color);
+void graphics_context_set_fill_color(GContext *ctx, GColor color);
+void graphics_context_set_text_color(GContext *ctx, GColor color);
+void graphics_context_set_stroke_width(GContext *ctx, uint8_t stroke_width);
+
+void graphics_draw_pixel(GContext *ctx, GPoint point);
+void graphics_draw_line(GContext *ctx, GPoint p0, GPoint p1);
+void graphics_draw_rect(GContext *ctx, GRect rect);
+void graphics_fill_rect(GContext *ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_fill_circle(GContext *ctx, GPoint p, uint16_t radius);
+void graphics_draw_text(GContext *ctx, const char *text, GFont const font, const GRect box,
+                        const GTextOverflowMode overflow_mode, const GTextAlignment alignment,
+                        GTextAttributes *text_attributes);
+
+// Layers
+
+typedef struct Layer Layer;
+typedef struct Window Window;
+typedef void (*LayerUpdateProc)(Layer *layer, GContext *ctx);
+
+Layer* layer_create(GRect frame);
+void layer_destroy(Layer *layer);
+void layer_set_update_proc(Layer *layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer *layer);
+void layer_add_child(Layer *parent, Layer *child);
+void layer_remove_from_parent(Layer *child);
+GRect layer_get_bounds(const Layer *layer);
+GRect layer_get_frame(const Layer *layer);
+void layer_set_hidden(Layer *layer, bool hidden);
+Window* layer_get_window(const Layer *layer);
+
+typedef struct TextLayer TextLayer;
+
+TextLayer* text_layer_create(GRect frame);
+void text_layer_destroy(TextLayer *text_layer);
+Layer* text_layer_get_layer(TextLayer *text_layer);
+void text_layer_set_text(TextLayer *text_layer, const char *text);
+const char* text_layer_get_text(TextLayer *text_layer);
+void text_layer_set_background_color(TextLayer *text_layer, GColor color);
+void text_layer_set_text_color(TextLayer *text_layer, GColor color);
+void text_layer_set_font(TextLayer *text_layer, GFont font);
+void text_layer_set_text_alignment(TextLayer *text_layer, GTextAlignment text_alignment);
+void text_layer_set_overflow_mode(TextLayer *text_layer, GTextOverflowMode line_mode);
+
+// Windows and buttons
+
+typedef enum {
+    BUTTON_ID_BACK = 0,
+    BUTTON_ID_UP,
+    BUTTON_ID_SELECT,
+    BUTTON_ID_DOWN,
+    NUM_BUTTONS
+} ButtonId;
+
+typedef void *ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void *context);
+typedef void (*ClickConfigProvider)(void *context);
+
+typedef void (*WindowHandler)(Window *window);
+
+typedef struct {
+    WindowHandler load;
+    WindowHandler appear;
+    WindowHandler disappear;
+    WindowHandler unload;
+} WindowHandlers;
+
+Window* window_create(void);
+void window_destroy(Window *window);
+void window_set_window_handlers(Window *window, WindowHandlers handlers);
+void window_set_background_color(Window *window, GColor background_color);
+void window_set_click_config_provider(Window *window, ClickConfigProvider click_config_provider);
+void window_set_click_config_provider_with_context(Window *window, ClickConfigProvider click_config_provider,
+                                                   void *context);
+Layer* window_get_root_layer(const Window *window);
+bool window_is_loaded(Window *window);
+void window_single_click_subscribe(ButtonId button_id, ClickHandler handler);
+
+void window_stack_push(Window *window, bool animated);
+Window* window_stack_pop(bool animated);
+Window* window_stack_get_top_window(void);
+
+// Menu layer
+
+typedef struct MenuLayer MenuLayer;
+
+typedef struct {
+    uint16_t section;
+    uint16_t row;
+} MenuIndex;
+
+typedef uint16_t (*MenuLayerGetNumberOfSectionsCallback)(MenuLayer *menu_layer, void *callback_context);
+typedef uint16_t (*MenuLayerGetNumberOfRowsInSectionsCallback)(MenuLayer *menu_layer, uint16_t section_index,
+                                                              void *callback_context);
+typedef int16_t (*MenuLayerGetCellHeightCallback)(MenuLayer *menu_layer, MenuIndex *cell_index,
+                                                  void *callback_context);
+typedef void (*MenuLayerDrawRowCallback)(GContext *ctx, const Layer *cell_layer, MenuIndex *cell_index,
+                                         void *callback_context);
+typedef void (*MenuLayerSelectCallback)(MenuLayer *menu_layer, MenuIndex *cell_index, void *callback_context);
+
+typedef struct {
+    MenuLayerGetNumberOfSectionsCallback get_num_sections;
+    MenuLayerGetNumberOfRowsInSectionsCallback get_num_rows;
+    MenuLayerGetCellHeightCallback get_cell_height;
+    MenuLayerDrawRowCallback draw_row;
+    MenuLayerSelectCallback select_click;
+} MenuLayerCallbacks;
+
+MenuLayer* menu_layer_create(GRect frame);
+void menu_layer_destroy(MenuLayer *menu_layer);
+Layer* menu_layer_get_layer(const MenuLayer *menu_layer);
+void menu_layer_set_callbacks(MenuLayer *menu_layer, void *callback_context, MenuLayerCallbacks callbacks);
+void menu_layer_set_normal_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_layer_set_highlight_colors(MenuLayer *menu_layer, GColor background, GColor foreground);
+void menu_layer_set_click_config_onto_window(MenuLayer *menu_layer, Window *window);
+void menu_layer_reload_data(MenuLayer *menu_layer);
+
+// App lifecycle
+
+void app_event_loop(void);
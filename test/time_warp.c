@@ -0,0 +1,507 @@
+// Time-warp simulator
+// Runs the real app against the host fakes for days or months of simulated
+// time, playing the phone side of AppMessage, and prints what the app cost
+// per day: wakeups, redraws, snprintf calls, persist writes and outbound
+// messages. Every prayer transition is checked, so a run also fails if the
+// watch misses one (quiet time, midnight, DST changes).
+
+#include <getopt.h>
+#include <math.h>
+#include "fake_pebble.h"
+#include "prayer_data.h"
+#include "prayer_display.h"
+#include "message_keys.h"
+
+// Entry point of the app (main.c is built with main renamed)
+int pebble_app_main(void);
+
+// Days per profile schedule sent by the phone (PROFILE_SCHEDULE_DAYS)
+#define PHONE_SCHEDULE_DAYS 30
+
+// Time after a prayer by which the watch must show the next one
+#define TRANSITION_GRACE_SECONDS 60
+
+// Phone response delays
+#define PHONE_READY_DELAY_MS 1000
+#define PHONE_FETCH_DELAY_MS 300
+#define PHONE_PROFILE_DELAY_MS 600
+
+static const char *PRAYER_NAMES[PRAYER_COUNT] = {
+    "Fajr", "Sunrise", "Dhuhr", "Asr", "Maghrib", "Isha"
+};
+
+// Scenario options
+static struct {
+    const char *start;
+    int days;
+    const char *tz;
+    int quiet_start;
+    int quiet_end;
+    bool profiles;
+    int list_hours;
+    bool verbose;
+    int max_missed;
+    long budget_wakeups;
+    long budget_redraws;
+    long budget_snprintf;
+    long budget_persist;
+    long budget_outbox;
+} s_options = {
+    .start = "2026-03-20",
+    .days = 30,
+    .tz = "Europe/London",
+    .quiet_start = -1,
+    .quiet_end = -1,
+    .max_missed = 0,
+    .budget_wakeups = -1,
+    .budget_redraws = -1,
+    .budget_snprintf = -1,
+    .budget_persist = -1,
+    .budget_outbox = -1
+};
+
+// Prayer times model
+// A smooth seasonal curve around a mid-latitude location on the prime
+// meridian: times are generated in UTC and converted to local time, so
+// DST changes shift them the way they do on the phone.
+
+static int day_of_year(time_t midnight) {
+    return localtime(&midnight)->tm_yday;
+}
+
+// UTC minutes since midnight of each prayer for a day of the year
+static void model_utc_minutes(int yday, double minutes[PRAYER_COUNT]) {
+    double season = 2 * M_PI * (yday - 80) / 365.0;
+    double b = 2 * M_PI * (yday - 81) / 364.0;
+    double equation_of_time = 9.87 * sin(2 * b) - 7.53 * cos(b) - 1.5 * sin(b);
+    double noon = 720 - equation_of_time;
+    double day_length = 720 + 250 * sin(season);
+
+    minutes[PRAYER_SUNRISE] = noon - day_length / 2;
+    minutes[PRAYER_FAJR] = minutes[PRAYER_SUNRISE] - 100;
+    minutes[PRAYER_DHUHR] = noon + 3;
+    minutes[PRAYER_ASR] = noon + day_length * 0.28;
+    minutes[PRAYER_MAGHRIB] = noon + day_length / 2;
+    minutes[PRAYER_ISHA] = minutes[PRAYER_MAGHRIB] + 100;
+}
+
+// Absolute times of each prayer on the local day starting at midnight
+static void model_prayer_epochs(time_t midnight, time_t epochs[PRAYER_COUNT]) {
+    struct tm date = *localtime(&midnight);
+    struct tm utc_midnight = { .tm_year = date.tm_year, .tm_mon = date.tm_mon, .tm_mday = date.tm_mday };
+    time_t base = timegm(&utc_midnight);
+
+    double minutes[PRAYER_COUNT];
+    model_utc_minutes(day_of_year(midnight), minutes);
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        // Whole minutes, as the phone sends them
+        epochs[i] = base + (time_t)minutes[i] * 60;
+    }
+}
+
+// Local minutes since midnight of each prayer, as sent to the watch
+static void model_local_minutes(time_t midnight, int16_t out[PRAYER_COUNT]) {
+    time_t epochs[PRAYER_COUNT];
+    model_prayer_epochs(midnight, epochs);
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        struct tm local = *localtime(&epochs[i]);
+        out[i] = (int16_t)(local.tm_hour * 60 + local.tm_min);
+    }
+}
+
+static time_t local_midnight(time_t t) {
+    struct tm midnight = *localtime(&t);
+    midnight.tm_hour = 0;
+    midnight.tm_min = 0;
+    midnight.tm_sec = 0;
+    midnight.tm_isdst = -1;
+    return mktime(&midnight);
+}
+
+static time_t next_midnight(time_t midnight) {
+    struct tm next = *localtime(&midnight);
+    next.tm_mday++;
+    next.tm_hour = 12; // Noon first, so DST can't land on the wrong day
+    next.tm_isdst = -1;
+    return local_midnight(mktime(&next));
+}
+
+// The prayer after a given time, and when it is
+static PrayerIndex model_next_prayer(time_t now, time_t *epoch) {
+    time_t midnight = local_midnight(now);
+    time_t epochs[PRAYER_COUNT];
+    model_prayer_epochs(midnight, epochs);
+
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        if (epochs[i] > now) {
+            *epoch = epochs[i];
+            return (PrayerIndex)i;
+        }
+    }
+    model_prayer_epochs(next_midnight(midnight), epochs);
+    *epoch = epochs[PRAYER_FAJR];
+    return PRAYER_FAJR;
+}
+
+// Phone (mirrors src/pkjs/index.js)
+
+static int s_watch_mask = -1;   // Coverage mask last reported by the watch (-1 = unknown)
+static uint8_t s_phone_sent_mask;
+
+static void format_12h(time_t epoch, char *buffer, size_t size) {
+    strftime(buffer, size, "%l:%M %p", localtime(&epoch));
+    if (buffer[0] == ' ') memmove(buffer, buffer + 1, strlen(buffer));
+}
+
+static void phone_send_profile(void *data) {
+    time_t midnight = local_midnight(sim_now());
+    uint8_t schedule[PHONE_SCHEDULE_DAYS * PRAYER_COUNT * 2];
+    time_t day = midnight;
+
+    for (int d = 0; d < PHONE_SCHEDULE_DAYS; d++) {
+        int16_t minutes[PRAYER_COUNT];
+        model_local_minutes(day, minutes);
+        for (int i = 0; i < PRAYER_COUNT; i++) {
+            schedule[(d * PRAYER_COUNT + i) * 2] = minutes[i] & 0xff;
+            schedule[(d * PRAYER_COUNT + i) * 2 + 1] = (minutes[i] >> 8) & 0xff;
+        }
+        day = next_midnight(day);
+    }
+
+    DictionaryIterator message;
+    sim_dict_init(&message);
+    dict_write_int32(&message, KEY_PROFILE_INDEX, 0);
+    dict_write_cstring(&message, KEY_PROFILE_NAME, "London");
+    dict_write_int32(&message, KEY_PROFILE_START, (int32_t)midnight);
+    dict_write_int32(&message, KEY_QIBLA_ANGLE, 20000);
+    dict_write_data(&message, KEY_PROFILE_SCHEDULE, schedule, sizeof(schedule));
+    sim_phone_send(&message, 0);
+
+    s_phone_sent_mask |= 1;
+    s_watch_mask |= 1;
+}
+
+static void phone_send_prayer_data(void *data) {
+    time_t now = sim_now();
+    int16_t minutes[PRAYER_COUNT];
+    model_local_minutes(local_midnight(now), minutes);
+
+    time_t next_epoch;
+    PrayerIndex next = model_next_prayer(now, &next_epoch);
+    char next_time[16];
+    format_12h(next_epoch, next_time, sizeof(next_time));
+
+    DictionaryIterator message;
+    sim_dict_init(&message);
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        dict_write_int32(&message, KEY_FAJR_TIME + i, minutes[i]);
+    }
+    dict_write_cstring(&message, KEY_NEXT_PRAYER_NAME, PRAYER_NAMES[next]);
+    dict_write_cstring(&message, KEY_NEXT_PRAYER_TIME, next_time);
+    dict_write_int32(&message, KEY_COUNTDOWN_SECONDS, (int32_t)(next_epoch - now));
+    dict_write_cstring(&message, KEY_LOCATION_NAME, "London");
+    dict_write_int32(&message, KEY_ERROR_CODE, 0);
+    sim_phone_send(&message, 0);
+
+    // Profile schedules follow once the watch has said what it holds
+    if (s_options.profiles && s_watch_mask >= 0 && !(s_watch_mask & 1)) {
+        sim_schedule(sim_now_ms() + PHONE_PROFILE_DELAY_MS, phone_send_profile, NULL);
+    }
+}
+
+static void phone_fetch(void *data) {
+    sim_schedule(sim_now_ms() + PHONE_FETCH_DELAY_MS, phone_send_prayer_data, NULL);
+}
+
+static void phone_receive(const DictionaryIterator *message) {
+    Tuple *mask = dict_find(message, KEY_PROFILE_MASK);
+    if (mask) {
+        s_watch_mask = mask->value->int32;
+    }
+    if (dict_find(message, KEY_REQUEST_DATA)) {
+        phone_fetch(NULL);
+    }
+}
+
+// Checks
+
+typedef struct {
+    PrayerIndex prayer;
+    time_t epoch;
+} TransitionCheck;
+
+static uint32_t s_day_transitions;
+static uint32_t s_day_missed;
+static uint32_t s_day_stale;
+static uint32_t s_total_missed;
+static uint32_t s_total_stale;
+
+// After a prayer, the watch must be counting down to the one after it
+static void check_transition(void *data) {
+    TransitionCheck *check = data;
+    time_t now = sim_now();
+    time_t expected_epoch;
+    PrayerIndex expected = model_next_prayer(now, &expected_epoch);
+
+    s_day_transitions++;
+    if (!g_prayer_data.data_valid || g_prayer_data.next_prayer_index != expected) {
+        s_day_missed++;
+        s_total_missed++;
+        if (s_options.verbose) {
+            char stamp[32];
+            strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M", localtime(&check->epoch));
+            fprintf(stderr, "MISSED %s at %s: watch shows %s (valid %d), expected %s\n",
+                    PRAYER_NAMES[check->prayer], stamp,
+                    PRAYER_NAMES[g_prayer_data.next_prayer_index], g_prayer_data.data_valid,
+                    PRAYER_NAMES[expected]);
+        }
+    } else if (window_stack_get_top_window() == prayer_display_get_window()) {
+        // A countdown that is on screen must match the real time left
+        int32_t remaining = (int32_t)(expected_epoch - now);
+        int32_t shown = g_prayer_data.countdown_seconds;
+        if (shown < remaining - 2 || shown > remaining + 2) {
+            s_day_stale++;
+            s_total_stale++;
+        }
+    }
+    free(check);
+}
+
+static void schedule_checks(time_t midnight) {
+    time_t epochs[PRAYER_COUNT];
+    model_prayer_epochs(midnight, epochs);
+
+    for (int i = 0; i < PRAYER_COUNT; i++) {
+        if (epochs[i] <= sim_now()) continue;
+        TransitionCheck *check = malloc(sizeof(TransitionCheck));
+        check->prayer = (PrayerIndex)i;
+        check->epoch = epochs[i];
+        sim_schedule((int64_t)(epochs[i] + TRANSITION_GRACE_SECONDS) * 1000, check_transition, check);
+    }
+}
+
+// Daily scenario: open the prayer list for a while at noon
+
+static void open_list(void *data) {
+    sim_click(BUTTON_ID_DOWN);
+}
+
+static void close_list(void *data) {
+    sim_click(BUTTON_ID_BACK);
+}
+
+static void schedule_day(time_t midnight) {
+    schedule_checks(midnight);
+
+    if (s_options.list_hours > 0) {
+        int64_t noon_ms = (int64_t)(midnight + 12 * 3600) * 1000;
+        sim_schedule(noon_ms, open_list, NULL);
+        sim_schedule(noon_ms + (int64_t)s_options.list_hours * 3600 * 1000, close_list, NULL);
+    }
+}
+
+// Report
+
+typedef struct {
+    uint32_t days;
+    SimCounters sum;
+    bool over_budget;
+} Totals;
+
+static Totals s_totals;
+static time_t s_day_start;
+
+static void print_header(void) {
+    printf("%-10s %3s %8s %7s %6s %5s %8s %8s %7s %6s %5s %11s %6s\n",
+           "Date", "Hrs", "Wakeups", "Ticks", "Timers", "Inbox", "Redraws",
+           "snprintf", "Persist", "Outbox", "Vibes", "Transitions", "Missed");
+}
+
+// Budgets are per 24 hours, so DST days get an hour more or less
+static bool over(long budget, uint32_t value, long hours) {
+    return budget >= 0 && (int64_t)value * 24 > (int64_t)budget * hours;
+}
+
+static void finish_day(time_t end) {
+    SimCounters *c = &g_sim_counters;
+    char date[16];
+    strftime(date, sizeof(date), "%Y-%m-%d", localtime(&s_day_start));
+    long hours = (long)((end - s_day_start + 1800) / 3600);
+
+    bool over_budget = over(s_options.budget_wakeups, c->wakeups, hours) ||
+                       over(s_options.budget_redraws, c->redraws, hours) ||
+                       over(s_options.budget_snprintf, c->snprintf_calls, hours) ||
+                       over(s_options.budget_persist, c->persist_writes, hours) ||
+                       over(s_options.budget_outbox, c->outbox_messages, hours);
+
+    printf("%-10s %3ld %8u %7u %6u %5u %8u %8u %7u %6u %5u %11u %6u%s%s\n",
+           date, hours, c->wakeups, c->ticks, c->timers,
+           c->inbox_messages, c->redraws, c->snprintf_calls, c->persist_writes,
+           c->outbox_messages, c->vibrations, s_day_transitions, s_day_missed,
+           s_day_stale ? "  stale countdown" : "", over_budget ? "  OVER BUDGET" : "");
+
+    s_totals.days++;
+    s_totals.sum.wakeups += c->wakeups;
+    s_totals.sum.ticks += c->ticks;
+    s_totals.sum.timers += c->timers;
+    s_totals.sum.inbox_messages += c->inbox_messages;
+    s_totals.sum.redraws += c->redraws;
+    s_totals.sum.snprintf_calls += c->snprintf_calls;
+    s_totals.sum.persist_writes += c->persist_writes;
+    s_totals.sum.persist_bytes += c->persist_bytes;
+    s_totals.sum.outbox_messages += c->outbox_messages;
+    s_totals.sum.vibrations += c->vibrations;
+    s_totals.over_budget |= over_budget;
+
+    sim_counters_reset();
+    s_day_transitions = 0;
+    s_day_missed = 0;
+    s_day_stale = 0;
+}
+
+static void on_new_day(time_t midnight) {
+    finish_day(midnight);
+    s_day_start = midnight;
+    schedule_day(midnight);
+}
+
+static void print_summary(void) {
+    SimCounters *t = &s_totals.sum;
+    double days = s_totals.days > 0 ? s_totals.days : 1;
+
+    printf("\n%-10s %3s %8u %7u %6u %5u %8u %8u %7u %6u %5u %11s %6u\n",
+           "Total", "", t->wakeups, t->ticks, t->timers, t->inbox_messages, t->redraws,
+           t->snprintf_calls, t->persist_writes, t->outbox_messages, t->vibrations, "", s_total_missed);
+    printf("%-10s %3s %8.0f %7.0f %6.1f %5.1f %8.0f %8.0f %7.1f %6.1f %5.1f\n",
+           "Per day", "", t->wakeups / days, t->ticks / days, t->timers / days,
+           t->inbox_messages / days, t->redraws / days, t->snprintf_calls / days,
+           t->persist_writes / days, t->outbox_messages / days, t->vibrations / days);
+    printf("\nPersisted %u bytes; %u missed transitions, %u stale countdowns\n",
+           t->persist_bytes, s_total_missed, s_total_stale);
+}
+
+// Options
+
+static void usage(const char *name) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --start YYYY-MM-DD    first simulated day (default %s)\n"
+            "  --days N              days to simulate (default %d)\n"
+            "  --tz ZONE             timezone (default %s)\n"
+            "  --quiet START-END     quiet time hours, e.g. 22-7\n"
+            "  --profiles            phone sends precomputed schedules\n"
+            "  --list-hours N        keep the prayer list open N hours from noon each day\n"
+            "  --max-missed N        fail with more missed transitions (default 0)\n"
+            "  --budget-wakeups N    fail if any day exceeds N wakeups per 24 hours\n"
+            "  --budget-redraws N    ... N redraws\n"
+            "  --budget-snprintf N   ... N snprintf calls\n"
+            "  --budget-persist N    ... N persist writes\n"
+            "  --budget-outbox N     ... N outbound messages\n"
+            "  --verbose             print app logs and missed transitions\n",
+            name, s_options.start, s_options.days, s_options.tz);
+}
+
+static bool parse_options(int argc, char **argv) {
+    enum {
+        OPT_START = 1, OPT_DAYS, OPT_TZ, OPT_QUIET, OPT_PROFILES, OPT_LIST_HOURS, OPT_MAX_MISSED,
+        OPT_BUDGET_WAKEUPS, OPT_BUDGET_REDRAWS, OPT_BUDGET_SNPRINTF, OPT_BUDGET_PERSIST,
+        OPT_BUDGET_OUTBOX, OPT_VERBOSE
+    };
+    static const struct option long_options[] = {
+        { "start", required_argument, NULL, OPT_START },
+        { "days", required_argument, NULL, OPT_DAYS },
+        { "tz", required_argument, NULL, OPT_TZ },
+        { "quiet", required_argument, NULL, OPT_QUIET },
+        { "profiles", no_argument, NULL, OPT_PROFILES },
+        { "list-hours", required_argument, NULL, OPT_LIST_HOURS },
+        { "max-missed", required_argument, NULL, OPT_MAX_MISSED },
+        { "budget-wakeups", required_argument, NULL, OPT_BUDGET_WAKEUPS },
+        { "budget-redraws", required_argument, NULL, OPT_BUDGET_REDRAWS },
+        { "budget-snprintf", required_argument, NULL, OPT_BUDGET_SNPRINTF },
+        { "budget-persist", required_argument, NULL, OPT_BUDGET_PERSIST },
+        { "budget-outbox", required_argument, NULL, OPT_BUDGET_OUTBOX },
+        { "verbose", no_argument, NULL, OPT_VERBOSE },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+
+    int option;
+    while ((option = getopt_long(argc, argv, "", long_options, NULL)) != -1) {
+        switch (option) {
+            case OPT_START: s_options.start = optarg; break;
+            case OPT_DAYS: s_options.days = atoi(optarg); break;
+            case OPT_TZ: s_options.tz = optarg; break;
+            case OPT_QUIET:
+                if (sscanf(optarg, "%d-%d", &s_options.quiet_start, &s_options.quiet_end) != 2) {
+                    return false;
+                }
+                break;
+            case OPT_PROFILES: s_options.profiles = true; break;
+            case OPT_LIST_HOURS: s_options.list_hours = atoi(optarg); break;
+            case OPT_MAX_MISSED: s_options.max_missed = atoi(optarg); break;
+            case OPT_BUDGET_WAKEUPS: s_options.budget_wakeups = atol(optarg); break;
+            case OPT_BUDGET_REDRAWS: s_options.budget_redraws = atol(optarg); break;
+            case OPT_BUDGET_SNPRINTF: s_options.budget_snprintf = atol(optarg); break;
+            case OPT_BUDGET_PERSIST: s_options.budget_persist = atol(optarg); break;
+            case OPT_BUDGET_OUTBOX: s_options.budget_outbox = atol(optarg); break;
+            case OPT_VERBOSE: s_options.verbose = true; break;
+            default: return false;
+        }
+    }
+    return s_options.days > 0;
+}
+
+int main(int argc, char **argv) {
+    if (!parse_options(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    setenv("TZ", s_options.tz, 1);
+    tzset();
+
+    struct tm start = { .tm_hour = 0, .tm_isdst = -1 };
+    if (!strptime(s_options.start, "%Y-%m-%d", &start)) {
+        usage(argv[0]);
+        return 2;
+    }
+    start.tm_isdst = -1;
+    time_t start_time = mktime(&start);
+
+    time_t end_time = start_time;
+    for (int i = 0; i < s_options.days; i++) {
+        end_time = next_midnight(end_time);
+    }
+
+    printf("Simulating %d days from %s in %s%s%s\n\n", s_options.days, s_options.start, s_options.tz,
+           s_options.profiles ? ", with profile schedules" : "",
+           s_options.quiet_start >= 0 ? ", with quiet time" : "");
+
+    sim_set_time(start_time);
+    sim_set_run_until(end_time - 1);
+    sim_set_verbose(s_options.verbose);
+    sim_set_quiet_time(s_options.quiet_start, s_options.quiet_end);
+    sim_set_phone_handler(phone_receive);
+    sim_set_day_callback(on_new_day);
+
+    // PebbleKit JS sends data as soon as it is ready
+    sim_schedule((int64_t)start_time * 1000 + PHONE_READY_DELAY_MS, phone_fetch, NULL);
+
+    s_day_start = start_time;
+    schedule_day(start_time);
+    print_header();
+
+    pebble_app_main();
+    finish_day(end_time);
+    print_summary();
+
+    if (s_total_missed > (uint32_t)s_options.max_missed) {
+        printf("FAIL: %u missed transitions (max %d)\n", s_total_missed, s_options.max_missed);
+        return 1;
+    }
+    if (s_totals.over_budget) {
+        printf("FAIL: over budget\n");
+        return 1;
+    }
+    return 0;
+}